@@ -0,0 +1,101 @@
+/*
+ * Arena.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+/**
+ * Allocates objects of the same type in large blocks. All the objects still
+ * alive are destroyed and all the memory is released in one step when the
+ * arena is destroyed. Objects may also be destroyed individually, in which case
+ * their memory is reused by the next allocation. Objects are created with
+ * placement new: new (arena.allocate()) T(...).
+ */
+template <class T>
+class Arena {
+public:
+  /**
+   * Constructor.
+   * @param blockSize The number of objects per block.
+   */
+  explicit Arena(const std::size_t blockSize = 4096) :
+      blockSize_(blockSize), used_(blockSize) {}
+
+  /**
+   * Destructor. Destroys the objects that are still alive and releases the
+   * memory.
+   */
+  ~Arena() {
+    std::sort(free_.begin(), free_.end());
+    for (std::size_t i = 0; i < blocks_.size(); ++i) {
+      T* block = blocks_[i];
+      std::size_t size = (i == blocks_.size() - 1 ? used_ : blockSize_);
+      for (std::size_t j = 0; j < size; ++j) {
+        if (!std::binary_search(free_.begin(), free_.end(), block + j)) {
+          block[j].~T();
+        }
+      }
+      ::operator delete(block);
+    }
+  }
+
+  /**
+   * Allocates memory for one object. The object needs to be constructed with
+   * placement new.
+   * @return The memory for one object.
+   */
+  void* allocate() {
+    if (!free_.empty()) {
+      T* res = free_.back();
+      free_.pop_back();
+      return res;
+    }
+    if (used_ == blockSize_) {
+      blocks_.push_back(
+          static_cast<T*>(::operator new(blockSize_ * sizeof(T))));
+      used_ = 0;
+    }
+    return blocks_.back() + used_++;
+  }
+
+  /**
+   * Destroys an object allocated by this arena. Its memory is reused by the
+   * next allocation.
+   * @param object The object to destroy.
+   */
+  void destroy(T* object) {
+    object->~T();
+    free_.push_back(object);
+  }
+
+private:
+  /** Number of objects per block. */
+  std::size_t blockSize_;
+  /** Number of objects allocated in the last block. */
+  std::size_t used_;
+  /** The blocks of memory. */
+  std::vector<T*> blocks_;
+  /** Objects destroyed whose memory can be reused. */
+  std::vector<T*> free_;
+
+  // not copyable
+  Arena(const Arena&);
+  void operator=(const Arena&);
+};
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
+
+#endif /* ARENA_H_ */
@@ -0,0 +1,95 @@
+/*
+ * BoundedQueue.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef BOUNDEDQUEUE_H_
+#define BOUNDEDQUEUE_H_
+
+#include <deque>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+/**
+ * Thread safe FIFO queue with a maximum size. Producers block when the queue
+ * is full and consumers block when the queue is empty. Once the producers are
+ * done, the queue is closed and consumers stop after the remaining elements
+ * have been consumed.
+ */
+template <class T>
+class BoundedQueue {
+public:
+  /**
+   * Constructor.
+   * @param capacity The maximum number of elements in the queue.
+   */
+  explicit BoundedQueue(const int capacity) :
+      capacity_(capacity), closed_(false) {}
+
+  /**
+   * Adds an element at the end of the queue. Blocks while the queue is full.
+   * @param element The element to add.
+   */
+  void push(const T& element) {
+    boost::mutex::scoped_lock lock(mutex_);
+    while (queue_.size() >= capacity_) {
+      notFull_.wait(lock);
+    }
+    queue_.push_back(element);
+    notEmpty_.notify_one();
+  }
+
+  /**
+   * Removes the element at the front of the queue. Blocks while the queue is
+   * empty and not closed.
+   * @param element The element removed.
+   * @return False if the queue is closed and empty, true otherwise.
+   */
+  bool pop(T* element) {
+    boost::mutex::scoped_lock lock(mutex_);
+    while (queue_.empty() && !closed_) {
+      notEmpty_.wait(lock);
+    }
+    if (queue_.empty()) {
+      return false;
+    }
+    *element = queue_.front();
+    queue_.pop_front();
+    notFull_.notify_one();
+    return true;
+  }
+
+  /**
+   * Indicates that no more elements will be added. Wakes up all the consumers.
+   */
+  void close() {
+    boost::mutex::scoped_lock lock(mutex_);
+    closed_ = true;
+    notEmpty_.notify_all();
+  }
+
+private:
+  /** Maximum number of elements in the queue. */
+  int capacity_;
+  /** Whether more elements will be added. */
+  bool closed_;
+  /** The elements. */
+  std::deque<T> queue_;
+  /** Protects all the fields. */
+  boost::mutex mutex_;
+  /** Signaled when an element is added or when the queue is closed. */
+  boost::condition_variable notEmpty_;
+  /** Signaled when an element is removed. */
+  boost::condition_variable notFull_;
+};
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
+
+#endif /* BOUNDEDQUEUE_H_ */
@@ -0,0 +1,149 @@
+/*
+ * CandidateIndex.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "CandidateIndex.h"
+
+#include <algorithm>
+#include <boost/functional/hash.hpp>
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+void CandidateIndex::build(const NgramTable& ngrams, const int sentenceSize) {
+  ngrams_ = &ngrams;
+  sentenceSize_ = sentenceSize;
+  startClass_.candidates.clear();
+  otherClass_.candidates.clear();
+  for (int ngram = 0; ngram < ngrams.size(); ++ngram) {
+    CandidateClass& candidateClass =
+        ngrams.startsWithStart(ngram) ? startClass_ : otherClass_;
+    for (int coverage = ngrams.coverageBegin(ngram);
+        coverage < ngrams.coverageEnd(ngram); ++coverage) {
+      Candidate candidate = { ngram, coverage };
+      candidateClass.candidates.push_back(candidate);
+    }
+  }
+  buildClass(&startClass_);
+  buildClass(&otherClass_);
+}
+
+void CandidateIndex::swap(CandidateIndex& other) {
+  startClass_.swap(other.startClass_);
+  otherClass_.swap(other.otherClass_);
+  std::swap(sentenceSize_, other.sentenceSize_);
+  std::swap(ngrams_, other.ngrams_);
+}
+
+void CandidateIndex::buildClass(CandidateClass* candidateClass) const {
+  const std::vector<Candidate>& candidates = candidateClass->candidates;
+  const int numBlocks = (candidates.size() + Coverage::kBitsPerBlock - 1) /
+      Coverage::kBitsPerBlock;
+  candidateClass->numBlocks = numBlocks;
+  candidateClass->positionMasks.assign(sentenceSize_ * numBlocks, 0);
+  candidateClass->prefixes.clear();
+  Coverage coverage;
+  for (int k = 0; k < candidates.size(); ++k) {
+    const int ngram = candidates[k].ngram;
+    ngrams_->coverage(candidates[k].coverage, &coverage);
+    for (std::size_t bit = coverage.findFirst(); bit != Coverage::npos;
+        bit = coverage.findNext(bit)) {
+      candidateClass->positionMasks[bit * numBlocks +
+                                    k / Coverage::kBitsPerBlock] |=
+          Block(1) << (k % Coverage::kBitsPerBlock);
+    }
+    // at least one word of the n-gram must be applied.
+    for (int size = 1; size < ngrams_->ngramSize(ngram); ++size) {
+      candidateClass->prefixes[hashPrefix(ngrams_->kenlmIndices(ngram), size)].
+          push_back(k);
+    }
+  }
+}
+
+std::size_t CandidateIndex::hashPrefix(const lm::WordIndex* words,
+                                       const int size) {
+  std::size_t res = boost::hash_range(words, words + size);
+  boost::hash_combine(res, size);
+  return res;
+}
+
+void CandidateIndex::find(const Coverage& coverage,
+                          const lm::ngram::State& history, const bool initial,
+                          const int maxOverlap, Scratch* scratch,
+                          std::vector<const Candidate*>* candidates) const {
+  candidates->clear();
+  const CandidateClass& candidateClass = initial ? startClass_ : otherClass_;
+  if (candidateClass.candidates.empty()) {
+    return;
+  }
+  scratch->positions.clear();
+  // an n-gram cannot overlap more words than there are in the history.
+  const int maxPrefix = std::min<int>(maxOverlap, history.length);
+  // the candidates without overlap come from the position masks and the
+  // candidates overlapping k positions from the history lookup.
+  findDisjoint(candidateClass, coverage, scratch);
+  if (maxPrefix > 0) {
+    const std::size_t numDisjoint = scratch->positions.size();
+    for (int size = 1; size <= maxPrefix; ++size) {
+      scratch->prefix.resize(size);
+      for (int i = 0; i < size; ++i) {
+        scratch->prefix[i] = history.words[size - 1 - i];
+      }
+      boost::unordered_map<std::size_t, std::vector<int> >::const_iterator
+          prefixIt = candidateClass.prefixes.find(
+              hashPrefix(&scratch->prefix[0], size));
+      if (prefixIt == candidateClass.prefixes.end()) {
+        continue;
+      }
+      const std::vector<int>& positions = prefixIt->second;
+      for (int i = 0; i < positions.size(); ++i) {
+        const Candidate& candidate = candidateClass.candidates[positions[i]];
+        if (coverage.intersectionCount(
+            ngrams_->coverageBlocks(candidate.coverage)) == size) {
+          scratch->positions.push_back(positions[i]);
+        }
+      }
+    }
+    if (scratch->positions.size() > numDisjoint) {
+      std::sort(scratch->positions.begin(), scratch->positions.end());
+    }
+  }
+  candidates->resize(scratch->positions.size());
+  for (int i = 0; i < scratch->positions.size(); ++i) {
+    (*candidates)[i] = &candidateClass.candidates[scratch->positions[i]];
+  }
+}
+
+void CandidateIndex::findDisjoint(const CandidateClass& candidateClass,
+                                  const Coverage& coverage,
+                                  Scratch* scratch) const {
+  const int numCandidates = candidateClass.candidates.size();
+  const int numBlocks = candidateClass.numBlocks;
+  // candidates covering at least one of the positions covered by the state.
+  scratch->overlapping.assign(numBlocks, 0);
+  Block* overlapping = &scratch->overlapping[0];
+  for (std::size_t bit = coverage.findFirst(); bit != Coverage::npos;
+      bit = coverage.findNext(bit)) {
+    const Block* mask = &candidateClass.positionMasks[bit * numBlocks];
+    for (int k = 0; k < numBlocks; ++k) {
+      overlapping[k] |= mask[k];
+    }
+  }
+  for (int k = 0; k < numBlocks; ++k) {
+    Block disjoint = ~overlapping[k];
+    if (k == numBlocks - 1 && numCandidates % Coverage::kBitsPerBlock) {
+      disjoint &= (Block(1) << (numCandidates % Coverage::kBitsPerBlock)) - 1;
+    }
+    for (; disjoint; disjoint &= disjoint - 1) {
+      scratch->positions.push_back(
+          k * Coverage::kBitsPerBlock + Coverage::lowestBit(disjoint));
+    }
+  }
+}
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
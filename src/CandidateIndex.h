@@ -0,0 +1,178 @@
+/*
+ * CandidateIndex.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef CANDIDATEINDEX_H_
+#define CANDIDATEINDEX_H_
+
+#include <algorithm>
+#include <vector>
+#include <boost/unordered_map.hpp>
+#include <lm/state.hh>
+
+#include "NgramTable.h"
+#include "Types.h"
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+/**
+ * An n-gram with one of its coverages, i.e. a possible extension of a state.
+ */
+struct Candidate {
+  /** The index of the n-gram in the table. */
+  int ngram;
+  /** The index of the coverage in the table. */
+  int coverage;
+};
+
+/**
+ * Index over the (n-gram, coverage) pairs of a chunk that enumerates, for a
+ * state, only the candidates whose coverage overlaps the state coverage by at
+ * most the allowed overlap. Candidates are split into n-grams starting with
+ * a start-of-sentence marker, which only extend the initial state, and the
+ * others. For each class and each input position, a bit mask over the
+ * candidates records those covering the position, so that the candidates
+ * disjoint from a state coverage are found with word-wide operations on the
+ * masks of the covered positions. With overlap, an n-gram overlapping k
+ * covered positions must start with the last k words of the state history, so
+ * the candidates are also indexed by the hash of their first words and the
+ * overlapping candidates are found by looking up the history of the state
+ * rather than by comparing the history with every n-gram.
+ * Candidates are enumerated in n-gram order then coverage order, which is the
+ * order of a scan of the n-gram map.
+ */
+class CandidateIndex {
+public:
+  /** Storage unit of the candidate masks. */
+  typedef Coverage::Block Block;
+
+  /**
+   * Memory reused between lookups.
+   */
+  struct Scratch {
+    /** Mask of the candidates overlapping a coverage. */
+    std::vector<Block> overlapping;
+    /** Positions of the candidates found in their class. */
+    std::vector<int> positions;
+    /** Last words of a history, in n-gram order. */
+    std::vector<lm::WordIndex> prefix;
+  };
+
+  /**
+   * Constructor. Creates an empty index.
+   */
+  CandidateIndex() : sentenceSize_(0), ngrams_(NULL) {}
+
+  /**
+   * Builds the index.
+   * @param ngrams The n-grams of a chunk. The table must outlive the index.
+   * @param sentenceSize The size of the input sentence.
+   */
+  void build(const NgramTable& ngrams, const int sentenceSize);
+
+  /**
+   * Swaps the content of two indices. Swapping with an empty index releases
+   * the memory of an index.
+   * @param other The other index.
+   */
+  void swap(CandidateIndex& other);
+
+  /**
+   * Getter.
+   * @return The n-grams the index was built from.
+   */
+  const NgramTable& ngrams() const {
+    return *ngrams_;
+  }
+
+  /**
+   * Finds the candidates that may extend a state.
+   * @param coverage The coverage of the state.
+   * @param history The history of the state. Only the words up to the length
+   * of the KenLM state are history, so candidates overlapping more positions
+   * than this length are not returned, as in Lattice::compatibleHistory.
+   * @param initial Whether the state is the initial state.
+   * @param maxOverlap The maximum overlap between the state coverage and a
+   * candidate coverage.
+   * @param scratch Memory reused between calls.
+   * @param candidates The resulting candidates, in n-gram order then coverage
+   * order. Overlapping candidates start with the history words, up to hash
+   * collisions.
+   */
+  void find(const Coverage& coverage, const lm::ngram::State& history,
+            const bool initial, const int maxOverlap, Scratch* scratch,
+            std::vector<const Candidate*>* candidates) const;
+
+private:
+  /**
+   * Candidates of a class together with their position masks.
+   */
+  struct CandidateClass {
+    /** The candidates, in n-gram order then coverage order. */
+    std::vector<Candidate> candidates;
+    /** Number of blocks of a mask. */
+    int numBlocks;
+    /** For each coverage bit, the mask of the candidates covering it, stored
+     * contiguously. */
+    std::vector<Block> positionMasks;
+    /** Positions of the candidates indexed by the hash of their first
+     * words, for each number of words less than the n-gram size. */
+    boost::unordered_map<std::size_t, std::vector<int> > prefixes;
+
+    /**
+     * Swaps the content of two classes.
+     * @param other The other class.
+     */
+    void swap(CandidateClass& other) {
+      candidates.swap(other.candidates);
+      std::swap(numBlocks, other.numBlocks);
+      positionMasks.swap(other.positionMasks);
+      prefixes.swap(other.prefixes);
+    }
+  };
+
+  /**
+   * Hashes the first words of an n-gram.
+   * @param words The KenLM indices of the words.
+   * @param size The number of words.
+   * @return The hash value.
+   */
+  static std::size_t hashPrefix(const lm::WordIndex* words, const int size);
+
+  /**
+   * Finds the candidates of a class whose coverage is disjoint from a
+   * coverage, in order.
+   * @param candidateClass The class.
+   * @param coverage The coverage.
+   * @param scratch Memory reused between calls. The positions of the
+   * candidates found are appended to the positions.
+   */
+  void findDisjoint(const CandidateClass& candidateClass,
+                    const Coverage& coverage, Scratch* scratch) const;
+
+  /**
+   * Builds the position masks and the prefix index of a class once its
+   * candidates are known.
+   * @param candidateClass The class.
+   */
+  void buildClass(CandidateClass* candidateClass) const;
+
+  /** N-grams starting with a start-of-sentence marker. */
+  CandidateClass startClass_;
+  /** Other n-grams. */
+  CandidateClass otherClass_;
+  /** Size of the input sentence. */
+  int sentenceSize_;
+  /** The n-grams the index was built from. */
+  const NgramTable* ngrams_;
+};
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
+
+#endif /* CANDIDATEINDEX_H_ */
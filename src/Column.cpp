@@ -7,6 +7,8 @@
 
 #include "Column.h"
 
+#include <algorithm>
+#include <limits>
 #include <glog/logging.h>
 
 #include "State.h"
@@ -16,6 +18,33 @@ namespace cam {
 namespace eng {
 namespace gen {
 
+namespace {
+
+/** Initial number of slots in the open addressing index. */
+const std::size_t kInitialCapacity = 16;
+
+/**
+ * Compares positions of states in a column by the cost of the states, then
+ * by state key.
+ */
+struct PositionComparator {
+  PositionComparator(const std::vector<State*>& states,
+                     const std::vector<Cost>& costs) :
+                       states_(states), costs_(costs) {}
+
+  bool operator()(const int p1, const int p2) const {
+    if (costs_[p1] != costs_[p2]) {
+      return costs_[p1] < costs_[p2];
+    }
+    return (states_[p1]->stateKey() < states_[p2]->stateKey());
+  }
+
+  const std::vector<State*>& states_;
+  const std::vector<Cost>& costs_;
+};
+
+} // namespace
+
 bool StatePointerComparator::operator()(const State* s1,
                                         const State* s2) const {
   // first compare by cost, then compare by state key (coverage + history)
@@ -25,23 +54,146 @@ bool StatePointerComparator::operator()(const State* s1,
   if (s1->cost() > s2->cost()) {
     return false;
   }
-  return (*(s1->stateKey()) < *(s2->stateKey()));
+  return (s1->stateKey() < s2->stateKey());
+}
+
+Column::Column() :
+    index_(kInitialCapacity, -1),
+    minCost_(std::numeric_limits<Cost>::infinity()),
+    pruneCost_(std::numeric_limits<Cost>::infinity()) {}
+
+bool Column::empty() const {
+  return states_.empty();
 }
 
-Column::~Column() {
-  for (boost::unordered_map<StateKey, State*>::const_iterator it =
-      statesIndexByStateKey_.begin(); it != statesIndexByStateKey_.end();
-      ++it) {
-    delete it->second;
+std::size_t Column::size() const {
+  return states_.size();
+}
+
+int Column::find(const Coverage& coverage, const lm::ngram::State& kenlmState,
+                 const std::size_t hash) const {
+  std::size_t mask = index_.size() - 1;
+  for (std::size_t slot = hash & mask; index_[slot] != -1;
+      slot = (slot + 1) & mask) {
+    int position = index_[slot];
+    if (hashes_[position] == hash &&
+        states_[position]->getKenlmState() == kenlmState &&
+        states_[position]->coverage() == coverage) {
+      return position;
+    }
   }
+  return -1;
 }
 
-bool Column::empty() const {
-  CHECK((statesIndexByStateKey_.empty() && statesSortedByCost_.empty()) ||
-        (!statesIndexByStateKey_.empty() && !statesSortedByCost_.empty())) <<
-            "The column state map and set should either be both empty or"
-            " both not empty.";
-  return (statesIndexByStateKey_.empty() && statesSortedByCost_.empty());
+State* Column::state(const int index) const {
+  return states_[index];
+}
+
+const std::vector<State*>& Column::states() const {
+  return states_;
+}
+
+void Column::add(State* state, const std::size_t hash) {
+  states_.push_back(state);
+  costs_.push_back(state->cost());
+  hashes_.push_back(hash);
+  minCost_ = std::min(minCost_, state->cost());
+  // keep the load factor under one half
+  if (2 * states_.size() > index_.size()) {
+    rebuildIndex(2 * index_.size());
+  } else {
+    insertIndex(states_.size() - 1);
+  }
+}
+
+void Column::updateCost(const int index, const Cost cost,
+                        const Cost futureCost) {
+  states_[index]->setCost(cost, futureCost);
+  costs_[index] = cost;
+  minCost_ = std::min(minCost_, cost);
+}
+
+Cost Column::minCost() const {
+  return minCost_;
+}
+
+Cost Column::pruneCost() const {
+  return pruneCost_;
+}
+
+void Column::prune(const int nbest, std::vector<State*>* pruned) {
+  if (states_.size() <= nbest) {
+    return;
+  }
+  std::vector<int> order(states_.size());
+  for (int i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  PositionComparator comparator(states_, costs_);
+  std::nth_element(order.begin(), order.begin() + nbest - 1, order.end(),
+                   comparator);
+  pruneCost_ = costs_[order[nbest - 1]];
+  for (int i = nbest; i < order.size(); ++i) {
+    pruned->push_back(states_[order[i]]);
+  }
+  order.resize(nbest);
+  // keep the insertion order of the remaining states
+  std::sort(order.begin(), order.end());
+  reorder(order);
+}
+
+void Column::sort() {
+  std::vector<int> order(states_.size());
+  for (int i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), PositionComparator(states_, costs_));
+  reorder(order);
+}
+
+void Column::release(std::vector<State*>* states) {
+  states->insert(states->end(), states_.begin(), states_.end());
+  std::vector<State*>().swap(states_);
+  std::vector<Cost>().swap(costs_);
+  std::vector<std::size_t>().swap(hashes_);
+  std::vector<int>(kInitialCapacity, -1).swap(index_);
+  minCost_ = std::numeric_limits<Cost>::infinity();
+  pruneCost_ = std::numeric_limits<Cost>::infinity();
+}
+
+void Column::rebuildIndex(const std::size_t capacity) {
+  index_.assign(capacity, -1);
+  for (int i = 0; i < states_.size(); ++i) {
+    insertIndex(i);
+  }
+}
+
+void Column::insertIndex(const int position) {
+  std::size_t mask = index_.size() - 1;
+  std::size_t slot = hashes_[position] & mask;
+  while (index_[slot] != -1) {
+    slot = (slot + 1) & mask;
+  }
+  index_[slot] = position;
+}
+
+void Column::reorder(const std::vector<int>& order) {
+  std::vector<State*> states(order.size());
+  std::vector<Cost> costs(order.size());
+  std::vector<std::size_t> hashes(order.size());
+  for (int i = 0; i < order.size(); ++i) {
+    states[i] = states_[order[i]];
+    costs[i] = costs_[order[i]];
+    hashes[i] = hashes_[order[i]];
+  }
+  states_.swap(states);
+  costs_.swap(costs);
+  hashes_.swap(hashes);
+  std::size_t capacity = kInitialCapacity;
+  while (capacity < 2 * states_.size()) {
+    capacity *= 2;
+  }
+  rebuildIndex(capacity);
 }
 
 } // namespace gen
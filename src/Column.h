@@ -8,18 +8,20 @@
 #ifndef COLUMN_H_
 #define COLUMN_H_
 
-#include <set>
-#include <boost/unordered_map.hpp>
+#include <vector>
+#include <lm/state.hh>
+
+#include "Types.h"
 
 namespace cam {
 namespace eng {
 namespace gen {
 
 class State;
-class StateKey;
 
 /**
- * State pointer comparator used to be able to use State* as a key in a set.
+ * State pointer comparator used to sort states by cost. Ties are broken by
+ * state key so that the order is deterministic.
  */
 struct StatePointerComparator {
   bool operator()(const State* s1, const State* s2) const;
@@ -28,27 +30,141 @@ struct StatePointerComparator {
 /**
  * A column in the lattice. A column has multiple states. We want to be able to
  * access these states quickly by a state key (history + coverage), so states
- * are indexed by a StateKey in a map. We also need to sort these states by cost
- * for pruning so states are also sorted by their cost in a set.
+ * are indexed by the hash of their state key in an open addressing table.
+ * States and their costs are stored in contiguous arrays. States are not kept
+ * sorted while the column is being filled: n-best pruning is done in batches
+ * by partial selection and the states are sorted by cost only once, when the
+ * column is about to be extended. States are owned by the lattice, not by the
+ * column.
  */
 class Column {
 public:
   /**
-   * Destructor. Custom destructor to delete states.
+   * Constructor.
    */
-  ~Column();
+  Column();
 
   /**
    * Checks if the column is empty, i.e. if it has no state.
-   * @return
+   * @return True if the column has no state.
    */
   bool empty() const;
 
+  /**
+   * Getter.
+   * @return The number of states in the column.
+   */
+  std::size_t size() const;
+
+  /**
+   * Finds a state by its state key.
+   * @param coverage The coverage of the state.
+   * @param kenlmState The history of the state.
+   * @param hash The hash of the state key, see StateKey::hash.
+   * @return The index of the state in the column, minus one if there is no
+   * such state.
+   */
+  int find(const Coverage& coverage, const lm::ngram::State& kenlmState,
+           const std::size_t hash) const;
+
+  /**
+   * Getter.
+   * @param index The index of the state in the column.
+   * @return The state.
+   */
+  State* state(const int index) const;
+
+  /**
+   * Getter.
+   * @return The states of the column. They are sorted by cost only after
+   * sort() has been called.
+   */
+  const std::vector<State*>& states() const;
+
+  /**
+   * Adds a state. The column must not already contain a state with the same
+   * state key.
+   * @param state The state.
+   * @param hash The hash of the state key, see StateKey::hash.
+   */
+  void add(State* state, const std::size_t hash);
+
+  /**
+   * Updates the cost of a state, used when a better path to a state is found.
+   * @param index The index of the state in the column.
+   * @param cost The new cost.
+   * @param futureCost The new future cost.
+   */
+  void updateCost(const int index, const Cost cost, const Cost futureCost);
+
+  /**
+   * Getter.
+   * @return The lowest cost in the column.
+   */
+  Cost minCost() const;
+
+  /**
+   * Getter. After n-best pruning, states with a cost greater or equal to this
+   * cost cannot be part of the n-best.
+   * @return The cost of the worst state kept by the last n-best pruning,
+   * infinity if the column has not been pruned.
+   */
+  Cost pruneCost() const;
+
+  /**
+   * Keeps only the n best states.
+   * @param nbest The number of states to keep.
+   * @param pruned The states removed from the column, to be released by the
+   * caller.
+   */
+  void prune(const int nbest, std::vector<State*>* pruned);
+
+  /**
+   * Sorts the states by cost.
+   */
+  void sort();
+
+  /**
+   * Removes all the states and releases the memory of the column, which is
+   * then empty as after construction.
+   * @param states The states removed from the column are appended, to be
+   * released by the caller.
+   */
+  void release(std::vector<State*>* states);
+
 private:
-  /** States indexed by StateKey (coverage + history). */
-  boost::unordered_map<StateKey, State*> statesIndexByStateKey_;
-  /** States sorted by their cost.*/
-  std::set<State*, StatePointerComparator> statesSortedByCost_;
+  /**
+   * Rebuilds the open addressing index from the states.
+   * @param capacity The number of slots, must be a power of two.
+   */
+  void rebuildIndex(const std::size_t capacity);
+
+  /**
+   * Inserts a state position in the open addressing index.
+   * @param position The position of the state in states_.
+   */
+  void insertIndex(const int position);
+
+  /**
+   * Reorders the states.
+   * @param order The positions of the states in the new order. States not in
+   * the order are removed.
+   */
+  void reorder(const std::vector<int>& order);
+
+  /** States, in insertion order or sorted by cost after sort(). */
+  std::vector<State*> states_;
+  /** Cost of each state, kept next to each other for pruning. */
+  std::vector<Cost> costs_;
+  /** Hash of the state key of each state. */
+  std::vector<std::size_t> hashes_;
+  /** Open addressing table with linear probing. Each slot contains a position
+   * in states_ or minus one if the slot is empty. */
+  std::vector<int> index_;
+  /** Lowest cost in the column. */
+  Cost minCost_;
+  /** Cost of the worst state kept by the last n-best pruning. */
+  Cost pruneCost_;
 
   template <class Arc> friend class Lattice;
   friend class LatticeTest;
@@ -0,0 +1,71 @@
+/*
+ * Coverage.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "Coverage.h"
+
+#include <iostream>
+#include <boost/functional/hash.hpp>
+#include <glog/logging.h>
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+const std::size_t Coverage::npos;
+
+Coverage::Coverage(const std::string& bits) : size_(0), numBlocks_(0),
+    heap_(NULL) {
+  clearInline();
+  resize(bits.size());
+  for (std::size_t i = 0; i < bits.size(); ++i) {
+    CHECK(bits[i] == '0' || bits[i] == '1') << "Wrong coverage string: " <<
+        bits;
+    if (bits[i] == '1') {
+      set(bits.size() - 1 - i);
+    }
+  }
+}
+
+void Coverage::resize(const std::size_t size) {
+  std::size_t numBlocks = (size + kBitsPerBlock - 1) / kBitsPerBlock;
+  if (numBlocks > kInlineBlocks && numBlocks > capacity_) {
+    Block* heap = new Block[numBlocks];
+    const Block* old = blocks();
+    for (std::size_t i = 0; i < numBlocks_; ++i) {
+      heap[i] = old[i];
+    }
+    delete[] heap_;
+    heap_ = heap;
+    capacity_ = numBlocks;
+  }
+  Block* b = blocks();
+  for (std::size_t i = numBlocks_; i < numBlocks; ++i) {
+    b[i] = 0;
+  }
+  size_ = size;
+  numBlocks_ = numBlocks;
+  // bits past the size are never set so that comparisons, counts and hashes
+  // can work on whole blocks.
+  if (size_ % kBitsPerBlock) {
+    b[numBlocks_ - 1] &= (Block(1) << (size_ % kBitsPerBlock)) - 1;
+  }
+}
+
+std::size_t Coverage::hash() const {
+  const Block* b = blocks();
+  return boost::hash_range(b, b + numBlocks_);
+}
+
+std::ostream& operator<<(std::ostream& os, const Coverage& coverage) {
+  for (std::size_t i = coverage.size(); i > 0; --i) {
+    os << (coverage.test(i - 1) ? '1' : '0');
+  }
+  return os;
+}
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
@@ -0,0 +1,497 @@
+/*
+ * Coverage.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef COVERAGE_H_
+#define COVERAGE_H_
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <boost/cstdint.hpp>
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+/**
+ * Coverage vector of the input. Bits are stored in 64 bit blocks. Sentences of
+ * up to kInlineBlocks * 64 words are stored inline without any heap
+ * allocation, so that the operations on coverages done for each state and each
+ * n-gram (intersection, union, population count, comparison) are plain loops
+ * over a few machine words that the compiler can unroll and vectorize. Longer
+ * sentences fall back to heap storage with the same interface.
+ * The bit layout and the comparison semantics are the ones of
+ * boost::dynamic_bitset: the coverage built from the string "1100" has bits 3
+ * and 2 set, i.e. position p in the input is stored in bit size() - 1 - p.
+ */
+class Coverage {
+public:
+  /** Storage unit for the bits. */
+  typedef boost::uint64_t Block;
+
+  enum {
+    /** Number of bits in a block. */
+    kBitsPerBlock = 64,
+    /** Number of blocks stored inline. */
+    kInlineBlocks = 4
+  };
+
+  /** Returned by findFirst() and findNext() when there is no bit set. */
+  static const std::size_t npos = static_cast<std::size_t>(-1);
+
+  /**
+   * Constructor. Creates an empty coverage.
+   */
+  Coverage() : size_(0), numBlocks_(0), heap_(NULL) {
+    clearInline();
+  }
+
+  /**
+   * Constructor. Creates a coverage with no bit set.
+   * @param size The number of bits.
+   */
+  explicit Coverage(const std::size_t size) : size_(0), numBlocks_(0),
+      heap_(NULL) {
+    clearInline();
+    resize(size);
+  }
+
+  /**
+   * Constructor from a string of '0' and '1'. The last character of the string
+   * is bit zero, as in boost::dynamic_bitset.
+   * @param bits The string.
+   */
+  explicit Coverage(const std::string& bits);
+
+  /**
+   * Copy constructor.
+   * @param other The coverage to copy.
+   */
+  Coverage(const Coverage& other) : size_(0), numBlocks_(0), heap_(NULL) {
+    clearInline();
+    *this = other;
+  }
+
+  /**
+   * Destructor. Releases the heap storage of long coverages.
+   */
+  ~Coverage() {
+    delete[] heap_;
+  }
+
+  /**
+   * Assignment. Reuses the storage of this coverage when it is large enough.
+   * @param other The coverage to copy.
+   * @return This coverage.
+   */
+  Coverage& operator=(const Coverage& other) {
+    if (this != &other) {
+      reserve(other.numBlocks_);
+      size_ = other.size_;
+      numBlocks_ = other.numBlocks_;
+      const Block* source = other.blocks();
+      Block* destination = blocks();
+      for (std::size_t i = 0; i < numBlocks_; ++i) {
+        destination[i] = source[i];
+      }
+    }
+    return *this;
+  }
+
+  /**
+   * Changes the number of bits. Bits that are added are not set.
+   * @param size The new number of bits.
+   */
+  void resize(const std::size_t size);
+
+  /**
+   * Getter.
+   * @return The number of bits.
+   */
+  std::size_t size() const {
+    return size_;
+  }
+
+  /**
+   * Getter.
+   * @return The number of blocks storing the bits.
+   */
+  std::size_t numBlocks() const {
+    return numBlocks_;
+  }
+
+  /**
+   * Getter.
+   * @return The blocks storing the bits, bit zero first.
+   */
+  const Block* data() const {
+    return blocks();
+  }
+
+  /**
+   * Copies bits stored in blocks, for example coverages stored in a file.
+   * The bits past the size must not be set.
+   * @param data The blocks, bit zero first.
+   * @param size The number of bits.
+   */
+  void assign(const Block* data, const std::size_t size) {
+    std::size_t numBlocks = (size + kBitsPerBlock - 1) / kBitsPerBlock;
+    reserve(numBlocks);
+    size_ = size;
+    numBlocks_ = numBlocks;
+    Block* destination = blocks();
+    for (std::size_t i = 0; i < numBlocks_; ++i) {
+      destination[i] = data[i];
+    }
+  }
+
+  /**
+   * Tests a bit.
+   * @param pos The bit index.
+   * @return True if the bit is set.
+   */
+  bool test(const std::size_t pos) const {
+    return (blocks()[pos / kBitsPerBlock] >> (pos % kBitsPerBlock)) & 1;
+  }
+
+  /**
+   * Sets a bit.
+   * @param pos The bit index.
+   * @return This coverage.
+   */
+  Coverage& set(const std::size_t pos) {
+    blocks()[pos / kBitsPerBlock] |= Block(1) << (pos % kBitsPerBlock);
+    return *this;
+  }
+
+  /**
+   * Counts the bits set.
+   * @return The number of bits set.
+   */
+  std::size_t count() const {
+    const Block* b = blocks();
+    std::size_t res = 0;
+    for (std::size_t i = 0; i < numBlocks_; ++i) {
+      res += popcount(b[i]);
+    }
+    return res;
+  }
+
+  /**
+   * Checks if no bit is set.
+   * @return True if no bit is set.
+   */
+  bool none() const {
+    const Block* b = blocks();
+    for (std::size_t i = 0; i < numBlocks_; ++i) {
+      if (b[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Counts the bits set in both this coverage and another coverage of the
+   * same size, without building the intersection.
+   * @param other The other coverage.
+   * @return The number of bits set in the intersection.
+   */
+  std::size_t intersectionCount(const Coverage& other) const {
+    return intersectionCount(other.blocks());
+  }
+
+  /**
+   * Counts the bits set in both this coverage and another coverage of the
+   * same size stored as blocks, e.g. in an n-gram table.
+   * @param other The blocks of the other coverage.
+   * @return The number of bits set in the intersection.
+   */
+  std::size_t intersectionCount(const Block* other) const {
+    const Block* a = blocks();
+    std::size_t res = 0;
+    for (std::size_t i = 0; i < numBlocks_; ++i) {
+      res += popcount(a[i] & other[i]);
+    }
+    return res;
+  }
+
+  /**
+   * Checks if all the bits set in this coverage are set in another coverage of
+   * the same size.
+   * @param other The other coverage.
+   * @return True if this coverage is a subset of the other coverage.
+   */
+  bool isSubsetOf(const Coverage& other) const {
+    const Block* a = blocks();
+    const Block* b = other.blocks();
+    for (std::size_t i = 0; i < numBlocks_; ++i) {
+      if (a[i] & ~b[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Finds the lowest bit set.
+   * @return The bit index, npos if no bit is set.
+   */
+  std::size_t findFirst() const {
+    return findFrom(0);
+  }
+
+  /**
+   * Finds the lowest bit set after a bit.
+   * @param pos The bit index.
+   * @return The bit index, npos if no bit after pos is set.
+   */
+  std::size_t findNext(const std::size_t pos) const {
+    return findFrom(pos + 1);
+  }
+
+  /**
+   * Intersection with a coverage of the same size.
+   * @param other The other coverage.
+   * @return This coverage.
+   */
+  Coverage& operator&=(const Coverage& other) {
+    Block* a = blocks();
+    const Block* b = other.blocks();
+    for (std::size_t i = 0; i < numBlocks_; ++i) {
+      a[i] &= b[i];
+    }
+    return *this;
+  }
+
+  /**
+   * Difference with a coverage of the same size: the bits set in the other
+   * coverage are reset.
+   * @param other The other coverage.
+   * @return This coverage.
+   */
+  Coverage& operator-=(const Coverage& other) {
+    Block* a = blocks();
+    const Block* b = other.blocks();
+    for (std::size_t i = 0; i < numBlocks_; ++i) {
+      a[i] &= ~b[i];
+    }
+    return *this;
+  }
+
+  /**
+   * Union with a coverage of the same size.
+   * @param other The other coverage.
+   * @return This coverage.
+   */
+  Coverage& operator|=(const Coverage& other) {
+    Block* a = blocks();
+    const Block* b = other.blocks();
+    for (std::size_t i = 0; i < numBlocks_; ++i) {
+      a[i] |= b[i];
+    }
+    return *this;
+  }
+
+  /**
+   * Equality.
+   * @param other The other coverage.
+   * @return True if both coverages have the same size and the same bits set.
+   */
+  bool operator==(const Coverage& other) const {
+    if (size_ != other.size_) {
+      return false;
+    }
+    const Block* a = blocks();
+    const Block* b = other.blocks();
+    for (std::size_t i = 0; i < numBlocks_; ++i) {
+      if (a[i] != b[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool operator!=(const Coverage& other) const {
+    return !(*this == other);
+  }
+
+  /**
+   * Comparison as unsigned numbers, most significant bit first, like
+   * boost::dynamic_bitset for coverages of the same size. Shorter coverages
+   * come first.
+   * @param other The other coverage.
+   * @return True if this coverage is less than the other one.
+   */
+  bool operator<(const Coverage& other) const {
+    if (size_ != other.size_) {
+      return size_ < other.size_;
+    }
+    const Block* a = blocks();
+    const Block* b = other.blocks();
+    for (std::size_t i = numBlocks_; i > 0; --i) {
+      if (a[i - 1] != b[i - 1]) {
+        return a[i - 1] < b[i - 1];
+      }
+    }
+    return false;
+  }
+
+  bool operator>(const Coverage& other) const {
+    return other < *this;
+  }
+
+  /**
+   * Computes a hash value of the bits.
+   * @return The hash value.
+   */
+  std::size_t hash() const;
+
+  /**
+   * Counts the bits set in a block.
+   * @param block The block.
+   * @return The number of bits set.
+   */
+  static std::size_t popcount(Block block) {
+#ifdef __GNUC__
+    return __builtin_popcountll(block);
+#else
+    std::size_t res = 0;
+    for (; block; block &= block - 1) {
+      ++res;
+    }
+    return res;
+#endif
+  }
+
+  /**
+   * Counts the trailing zero bits of a block that is not zero.
+   * @param block The block.
+   * @return The index of the lowest bit set.
+   */
+  static std::size_t lowestBit(Block block) {
+#ifdef __GNUC__
+    return __builtin_ctzll(block);
+#else
+    std::size_t res = 0;
+    for (; !(block & 1); block >>= 1) {
+      ++res;
+    }
+    return res;
+#endif
+  }
+
+private:
+  /**
+   * Finds the lowest bit set from a bit.
+   * @param pos The bit index.
+   * @return The bit index, npos if no bit from pos is set.
+   */
+  std::size_t findFrom(const std::size_t pos) const {
+    if (pos >= size_) {
+      return npos;
+    }
+    const Block* b = blocks();
+    std::size_t i = pos / kBitsPerBlock;
+    Block block = b[i] & (~Block(0) << (pos % kBitsPerBlock));
+    while (!block) {
+      if (++i == numBlocks_) {
+        return npos;
+      }
+      block = b[i];
+    }
+    return i * kBitsPerBlock + lowestBit(block);
+  }
+
+  /**
+   * Makes sure the storage can hold a number of blocks. The content is not
+   * preserved.
+   * @param numBlocks The number of blocks.
+   */
+  void reserve(const std::size_t numBlocks) {
+    if (numBlocks > kInlineBlocks && numBlocks > capacity_) {
+      delete[] heap_;
+      heap_ = new Block[numBlocks];
+      capacity_ = numBlocks;
+    }
+  }
+
+  /**
+   * Clears the inline storage so that unused bits are never set.
+   */
+  void clearInline() {
+    capacity_ = 0;
+    for (int i = 0; i < kInlineBlocks; ++i) {
+      inline_[i] = 0;
+    }
+  }
+
+  Block* blocks() {
+    return heap_ ? heap_ : inline_;
+  }
+
+  const Block* blocks() const {
+    return heap_ ? heap_ : inline_;
+  }
+
+  /** Number of bits. */
+  std::size_t size_;
+  /** Number of blocks in use. */
+  std::size_t numBlocks_;
+  /** Number of blocks of the heap storage. */
+  std::size_t capacity_;
+  /** Heap storage, NULL if the blocks are stored inline. */
+  Block* heap_;
+  /** Inline storage for short coverages. */
+  Block inline_[kInlineBlocks];
+};
+
+/**
+ * Intersection of two coverages of the same size.
+ * @param c1 The first coverage.
+ * @param c2 The second coverage.
+ * @return The intersection.
+ */
+inline Coverage operator&(const Coverage& c1, const Coverage& c2) {
+  Coverage res(c1);
+  res &= c2;
+  return res;
+}
+
+/**
+ * Union of two coverages of the same size.
+ * @param c1 The first coverage.
+ * @param c2 The second coverage.
+ * @return The union.
+ */
+inline Coverage operator|(const Coverage& c1, const Coverage& c2) {
+  Coverage res(c1);
+  res |= c2;
+  return res;
+}
+
+/**
+ * Prints a coverage most significant bit first, as boost::dynamic_bitset.
+ * @param os The output stream.
+ * @param coverage The coverage.
+ * @return The output stream.
+ */
+std::ostream& operator<<(std::ostream& os, const Coverage& coverage);
+
+/**
+ * Hash function to be used with boost::hash.
+ * @param coverage The coverage to hash.
+ * @return The hash value.
+ */
+inline std::size_t hash_value(const Coverage& coverage) {
+  return coverage.hash();
+}
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
+
+#endif /* COVERAGE_H_ */
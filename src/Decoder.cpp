@@ -6,7 +6,11 @@
  */
 
 #include "Decoder.h"
+
+#include <boost/filesystem.hpp>
+
 #include "Chop.h"
+#include "FutureCost.h"
 #include "Range.h"
 
 namespace cam {
@@ -25,17 +29,38 @@ Decoder::Decoder(const std::string& sentenceFile, const std::string& ngrams,
                  const std::string& punctuation, const std::string& wordmap,
                  const std::string& chopFile, const std::string& constraints,
                  const std::string& constraintsFile, const bool allowDeletion,
-                 const std::string& futureCostLm) :
+                 const std::string& futureCostLm, const int threads,
+                 const int extendThreads, const std::string& lmCache,
+                 const std::string& globalLm,
+                 const std::string& lmLoadMethod,
+                 const int pipelineQueueSize,
+                 const int lmTransitionCacheSize,
+                 const bool futureCostFromLm,
+                 const bool ngramFutureCost,
+                 const int inflateThreads,
+                 const bool lazyNgramLoading,
+                 const bool releaseColumns,
+                 const bool lazyFst) :
                    ngrams_(ngrams), lm_(lm), fstOutput_(fstOutput),
                    range_(range), overlap_(overlap), pruneNbest_(pruneNbest),
                    pruneNbestInputLengthSpecific_(pruneNbestInputLengthSpecific),
                    pruneThreshold_(pruneThreshold), dumpPrune_(dumpPrune),
                    addInput_(addInput), whenLostInput_(whenLostInput),
                    task_(task), allowDeletion_(allowDeletion),
-                   futureCostLm_(futureCostLm) {
+                   futureCostLm_(futureCostLm), threads_(threads),
+                   extendThreads_(extendThreads),
+                   languageModelLoader_(lmCache, lmLoadMethod),
+                   pipelineQueueSize_(pipelineQueueSize),
+                   lmTransitionCacheSize_(lmTransitionCacheSize),
+                   futureCostFromLm_(futureCostFromLm),
+                   ngramFutureCost_(ngramFutureCost),
+                   inflateThreads_(inflateThreads),
+                   lazyNgramLoading_(lazyNgramLoading),
+                   releaseColumns_(releaseColumns), lazyFst_(lazyFst) {
   parseInput(sentenceFile);
   parseFeatures(features);
   parseWeights(weights);
+  featureSet_.reset(new FeatureSet(features_, weights_));
   if (chop == "silly") {
     chopper_.reset(new SillyChopper(maxChop));
   } else if (chop == "punctuation") {
@@ -50,47 +75,90 @@ Decoder::Decoder(const std::string& sentenceFile, const std::string& ngrams,
   } else {
     constraints_.reset(new Constraints());
   }
+  if (!globalLm.empty()) {
+    LOG(INFO) << "Loading global language model " << globalLm;
+    globalLanguageModel_ = languageModelLoader_.load(globalLm);
+    CHECK(globalLanguageModel_->hasEndSentence()) << "The language model " <<
+        globalLm << " has no end-of-sentence marker </s>";
+  }
 }
 
 void Decoder::decode() const {
+  std::vector<int> ids;
   for (boost::scoped_ptr<IntegerRangeInterface> ir(
       IntegerRangeInterface::initFactory(range_)); !ir->done(); ir->next()) {
-    int id = ir->get();
-    LOG(INFO)<< "Processing sentence number " << id;
-    decode(inputSentences_[id - 1], id);
+    ids.push_back(ir->get());
+  }
+  if (task_ == "decode") {
+    decodeSentences<fst::StdArc>(ids);
+  } else if (task_ == "tune") {
+    decodeSentences<TupleArc32>(ids);
   }
 }
 
-void Decoder::decode(
-    const std::vector<int>& inputSentence, const int id) const {
-  std::vector<int> splitPositions = chopper_->chop(inputSentence, id);
+void Decoder::load(const int id, SentenceData* data) const {
+  const std::vector<int>& inputSentence = inputSentences_[id - 1];
+  data->id = id;
+  data->splitPositions = chopper_->chop(inputSentence, id);
   std::vector<bool> chunksToReorder = constraints_->constrain(id);
-  NgramLoader ngramLoader(inputSentence);
-  std::ostringstream ngramFile;
-  ngramFile << ngrams_ << "/" << id << ".r.gz";
-  ngramLoader.loadNgram(ngramFile.str(), splitPositions, chunksToReorder);
-  std::ostringstream lmFile;
-  lmFile << lm_ << "/" << id << "/lm.4.gz";
-  boost::shared_ptr<lm::ngram::Model> languageModel(
-      new lm::ngram::Model(lmFile.str().c_str()));
-  boost::shared_ptr<lm::ngram::Model> futureCostLanguageModel;
+  data->languageModel = globalLanguageModel_;
+  if (!data->languageModel) {
+    std::ostringstream lmFile;
+    lmFile << lm_ << "/" << id << "/lm.4.gz";
+    data->languageModel = languageModelLoader_.load(lmFile.str());
+    CHECK(data->languageModel->hasEndSentence()) << "The language model " <<
+        lmFile.str() << " has no end-of-sentence marker </s>";
+  }
+  // the language model is loaded first so that the n-grams are translated to
+  // KenLM indices while they are loaded.
+  data->ngramLoader.reset(new NgramLoader(
+      inputSentence, data->languageModel, featureSet_, task_ == "tune"));
+  // n-gram files converted to binary format by NgramConvert are preferred
+  // over the text files, unless the text file was modified after the
+  // conversion.
+  std::ostringstream binaryFile;
+  binaryFile << ngrams_ << "/" << id << ".r.bin";
+  std::ostringstream textFile;
+  textFile << ngrams_ << "/" << id << ".r.gz";
+  std::string ngramFile = textFile.str();
+  if (boost::filesystem::exists(binaryFile.str())) {
+    if (!boost::filesystem::exists(textFile.str()) ||
+        boost::filesystem::last_write_time(binaryFile.str()) >=
+        boost::filesystem::last_write_time(textFile.str())) {
+      ngramFile = binaryFile.str();
+    } else {
+      LOG(WARNING) << "Ignoring " << binaryFile.str() << ", older than " <<
+          textFile.str() << ". Run NgramConvert again.";
+    }
+  }
+  data->ngramLoader->loadNgram(ngramFile, data->splitPositions,
+                               chunksToReorder, inflateThreads_,
+                               lazyNgramLoading_);
   if (!futureCostLm_.empty()) {
     std::ostringstream futureCostLmFile;
     futureCostLmFile << futureCostLm_ << "/" << id << "/lm.1";
-    futureCostLanguageModel.reset(
-        new lm::ngram::Model(futureCostLmFile.str().c_str()));
+    boost::shared_ptr<LanguageModel> futureCostLanguageModel =
+        languageModelLoader_.load(futureCostLmFile.str());
+    unigramFutureCosts(inputSentence, *futureCostLanguageModel,
+                       &data->futureCosts);
+  } else if (futureCostFromLm_) {
+    unigramFutureCosts(inputSentence, *data->languageModel,
+                       &data->futureCosts);
+  } else if (ngramFutureCost_) {
+    ngramFutureCosts(inputSentence, *data->ngramLoader, *data->languageModel,
+                     allowDeletion_, &data->futureCosts);
   }
-  if (task_ == "decode") {
-    decode<fst::StdArc>(inputSentence, splitPositions, ngramLoader, id,
-                        new Lattice<fst::StdArc>(
-                            inputSentence, languageModel, features_, weights_,
-                            futureCostLanguageModel));
-  } else if (task_ == "tune") {
-    decode<TupleArc32>(inputSentence, splitPositions, ngramLoader, id,
-                       new Lattice<TupleArc32>(
-                           inputSentence, languageModel, features_, weights_,
-                           futureCostLanguageModel));
+}
+
+void Decoder::loadStage(
+    const std::vector<int>& ids,
+    BoundedQueue<boost::shared_ptr<SentenceData> >* loaded) const {
+  for (int i = 0; i < ids.size(); ++i) {
+    boost::shared_ptr<SentenceData> data(new SentenceData());
+    load(ids[i], data.get());
+    loaded->push(data);
   }
+  loaded->close();
 }
 
 void Decoder::parseInput(const std::string& fileName) {
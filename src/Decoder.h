@@ -8,7 +8,13 @@
 #ifndef DECODER_H_
 #define DECODER_H_
 
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "BoundedQueue.h"
 #include "Constraints.h"
+#include "LanguageModelLoader.h"
 #include "Lattice.h"
 
 namespace cam {
@@ -53,6 +59,34 @@ public:
    * @param futureCostLm Directory containing unigram language
    * models to estimate a future cost. The unigram language models are applied
    * to the words not yet covered.
+   * @param threads Number of sentences decoded in parallel.
+   * @param extendThreads Number of threads used to expand the states of a
+   * column.
+   * @param lmCache Directory where language models are cached in KenLM binary
+   * format. If empty, language models are not cached.
+   * @param globalLm Language model shared by all sentences. If not empty, this
+   * language model is loaded once and used instead of the per sentence
+   * language models in the lm directory.
+   * @param lmLoadMethod How binary language models are loaded: "lazy",
+   * "populate" or "read".
+   * @param pipelineQueueSize If greater than zero, loading, searching and
+   * writing sentences are done by different threads connected by queues of
+   * this size.
+   * @param lmTransitionCacheSize Number of language model transitions cached
+   * by each thread extending states. Zero disables the cache.
+   * @param futureCostFromLm Whether the future cost is estimated with the
+   * unigram probabilities of the main language model rather than with a
+   * separate unigram language model.
+   * @param ngramFutureCost Whether the future cost is estimated from the
+   * n-grams of each sentence and the language model.
+   * @param inflateThreads Number of threads used to decompress n-gram files
+   * made of several gzip members.
+   * @param lazyNgramLoading Whether the n-grams of a chunk are only loaded
+   * when the search reaches the chunk.
+   * @param releaseColumns Whether the states of a column are released as soon
+   * as the column is extended.
+   * @param lazyFst Whether the output fst is built after search from the
+   * hypotheses that reach the last column.
    */
   Decoder(
       const std::string& sentenceFile, const std::string& ngrams,
@@ -66,14 +100,134 @@ public:
       const std::string& punctuation, const std::string& wordmap,
       const std::string& chopFile, const std::string& constraints,
       const std::string& constraintsFile, const bool allowDeletion,
-      const std::string& futureCostLm);
+      const std::string& futureCostLm, const int threads,
+      const int extendThreads, const std::string& lmCache,
+      const std::string& globalLm, const std::string& lmLoadMethod,
+      const int pipelineQueueSize, const int lmTransitionCacheSize,
+      const bool futureCostFromLm, const bool ngramFutureCost,
+      const int inflateThreads, const bool lazyNgramLoading,
+      const bool releaseColumns, const bool lazyFst);
 
   /**
-   * Decodes everything.
+   * Decodes everything. If more than one thread is requested, sentences are
+   * distributed to a pool of worker threads. If pipelining is requested,
+   * sentences are loaded, searched and written by different threads.
    */
   void decode() const;
 
 private:
+  /**
+   * Everything needed to search a sentence, loaded from disk.
+   */
+  struct SentenceData {
+    /** The id of the sentence (coming from a range). */
+    int id;
+    /** Where to split the sentence into chunks. */
+    std::vector<int> splitPositions;
+    /** The n-grams relevant to the sentence. */
+    boost::shared_ptr<NgramLoader> ngramLoader;
+    /** The language model. */
+    boost::shared_ptr<LanguageModel> languageModel;
+    /** The estimated future cost of each input word. Empty if no future cost
+     * is estimated. */
+    std::vector<Cost> futureCosts;
+  };
+
+  /** A searched lattice with the id of its sentence. */
+  template <class Arc>
+  struct SearchedSentence {
+    /** The id of the sentence. */
+    int id;
+    /** The lattice obtained after search. */
+    boost::shared_ptr<Lattice<Arc> > lattice;
+  };
+
+  /**
+   * Decodes a list of sentences, serially, with a pool of threads or with a
+   * pipeline depending on the options.
+   * @param ids The sentence ids to decode.
+   */
+  template <class Arc>
+  void decodeSentences(const std::vector<int>& ids) const;
+
+  /**
+   * Worker loop for multithreaded decoding. Repeatedly takes the next
+   * sentence id that has not been processed yet and decodes it, until no
+   * sentence is left.
+   * @param ids The sentence ids to decode.
+   * @param nextId Index in ids of the next sentence to decode. Shared between
+   * workers and protected by mutex.
+   * @param mutex Mutex protecting nextId.
+   */
+  template <class Arc>
+  void decodeWorker(const std::vector<int>& ids, std::size_t* nextId,
+                    boost::mutex* mutex) const;
+
+  /**
+   * Decodes a specific sentence: loads, searches and writes the output.
+   * @param id The id of the sentence (coming from a range).
+   */
+  template <class Arc>
+  void decodeSentence(const int id) const;
+
+  /**
+   * Loads the n-grams and language models for a sentence. Possibly chops the
+   * input so that the chunks are decoded separately.
+   * @param id The id of the sentence (coming from a range).
+   * @param data The loaded data.
+   */
+  void load(const int id, SentenceData* data) const;
+
+  /**
+   * Searches a sentence, chunk by chunk if the sentence is chopped.
+   * @param data The n-grams and language models for the sentence.
+   * @return The lattice after search.
+   */
+  template <class Arc>
+  boost::shared_ptr<Lattice<Arc> > search(const SentenceData& data) const;
+
+  /**
+   * Compacts a lattice and writes it to the output directory.
+   * @param id The id of the sentence.
+   * @param lattice The lattice.
+   */
+  template <class Arc>
+  void write(const int id, Lattice<Arc>* lattice) const;
+
+  /**
+   * Writes a compacted lattice to the output directory.
+   * @param id The id of the sentence.
+   * @param lattice The lattice, already compacted.
+   */
+  template <class Arc>
+  void writeCompacted(const int id, const Lattice<Arc>& lattice) const;
+
+  /**
+   * First stage of the pipeline: loads sentences.
+   * @param ids The sentence ids to load.
+   * @param loaded The queue receiving loaded sentences. Closed at the end.
+   */
+  void loadStage(const std::vector<int>& ids,
+                 BoundedQueue<boost::shared_ptr<SentenceData> >* loaded) const;
+
+  /**
+   * Second stage of the pipeline: searches loaded sentences and compacts the
+   * lattices. There may be multiple threads running this stage, so that
+   * compaction, which is expensive, runs in parallel as well.
+   * @param loaded The queue of loaded sentences.
+   * @param searched The queue receiving searched and compacted lattices.
+   */
+  template <class Arc>
+  void searchStage(BoundedQueue<boost::shared_ptr<SentenceData> >* loaded,
+                   BoundedQueue<SearchedSentence<Arc> >* searched) const;
+
+  /**
+   * Third stage of the pipeline: writes compacted lattices.
+   * @param searched The queue of compacted lattices.
+   */
+  template <class Arc>
+  void writeStage(BoundedQueue<SearchedSentence<Arc> >* searched) const;
+
   /**
    * Reads a file line by line, each line is tokenized by whitespace.
    * @param fileName The input file name.
@@ -94,33 +248,14 @@ private:
    */
   void parseWeights(const std::string& featureWeights);
 
-  /**
-   * Decodes a specific sentence. Possibly chops the input and decodes the
-   * chunks separately.
-   * @param inputSentence The input sentence to decode.
-   * @param id The id of the sentence (coming from a range).
-   */
-  void decode(const std::vector<int>& inputSentence, const int id) const;
-
-  /**
-   * Decodes a sequence of words. Could be a sentence or a chunk.
-   * @param inputWords The input words to decode.
-   * @param ngramLoader Object containing the list of n-grams relevant to the
-   * input words.
-   * @param lattice The output lattice.
-   */
-  template <class Arc>
-  void decode(
-      const std::vector<int>& inputSentence,
-      const std::vector<int>& splitPositions, const NgramLoader& ngramLoader,
-      const int id, Lattice<Arc>* lattice) const;
-
   /** Input sentences to decode. */
   std::vector<std::vector<int> > inputSentences_;
   /** Feature names. */
   std::vector<std::string> features_;
   /** Feature weights. */
   Weights weights_;
+  /** Features resolved from their names, with their weights. */
+  boost::shared_ptr<FeatureSet> featureSet_;
   /** N-gram directory. */
   std::string ngrams_;
   /** Language model directory. */
@@ -157,17 +292,121 @@ private:
    * models to estimate a future cost. The unigram language models are applied
    * to the words not yet covered. */
   std::string futureCostLm_;
+  /** Number of sentences decoded in parallel. */
+  int threads_;
+  /** Number of threads used to expand the states of a column. */
+  int extendThreads_;
+  /** Loads language models, possibly from a cache of binary files. */
+  LanguageModelLoader languageModelLoader_;
+  /** Language model shared by all sentences and all threads. NULL if each
+   * sentence has its own language model. */
+  boost::shared_ptr<LanguageModel> globalLanguageModel_;
+  /** Size of the queues between the load, search and write stages. If zero,
+   * the stages are not pipelined. */
+  int pipelineQueueSize_;
+  /** Number of language model transitions cached by each thread extending
+   * states. */
+  int lmTransitionCacheSize_;
+  /** Whether the future cost is estimated with the main language model. */
+  bool futureCostFromLm_;
+  /** Whether the future cost is estimated from the n-grams of the
+   * sentence. */
+  bool ngramFutureCost_;
+  /** Number of threads used to decompress n-gram files. */
+  int inflateThreads_;
+  /** Whether the n-grams of a chunk are loaded when the search reaches the
+   * chunk. */
+  bool lazyNgramLoading_;
+  /** Whether the states of a column are released once it is extended. */
+  bool releaseColumns_;
+  /** Whether the output fst is built after search. */
+  bool lazyFst_;
 };
 
 template <class Arc>
-void Decoder::decode(
-    const std::vector<int>& inputSentence,
-    const std::vector<int>& splitPositions, const NgramLoader& ngramLoader,
-    const int id, Lattice<Arc>* lattice) const {
+void Decoder::decodeSentences(const std::vector<int>& ids) const {
+  if (pipelineQueueSize_ > 0) {
+    // loading sentence k+1, searching sentence k and writing sentence k-1
+    // happen at the same time.
+    BoundedQueue<boost::shared_ptr<SentenceData> > loaded(pipelineQueueSize_);
+    BoundedQueue<SearchedSentence<Arc> > searched(pipelineQueueSize_);
+    boost::thread loader(
+        boost::bind(&Decoder::loadStage, this, boost::cref(ids), &loaded));
+    boost::thread_group searchers;
+    for (int i = 0; i < threads_; ++i) {
+      searchers.create_thread(boost::bind(&Decoder::searchStage<Arc>, this,
+                                          &loaded, &searched));
+    }
+    boost::thread writer(
+        boost::bind(&Decoder::writeStage<Arc>, this, &searched));
+    loader.join();
+    searchers.join_all();
+    searched.close();
+    writer.join();
+    return;
+  }
+  if (threads_ <= 1) {
+    for (int i = 0; i < ids.size(); ++i) {
+      decodeSentence<Arc>(ids[i]);
+    }
+    return;
+  }
+  // sentences are independent (each one has its own n-grams, language model,
+  // lattice and output file) so workers simply take the next sentence
+  // available. Since each sentence is written to its own file, the output
+  // does not depend on the order in which sentences are finished.
+  std::size_t nextId = 0;
+  boost::mutex mutex;
+  boost::thread_group workers;
+  for (int i = 0; i < threads_; ++i) {
+    workers.create_thread(boost::bind(&Decoder::decodeWorker<Arc>, this,
+                                      boost::cref(ids), &nextId, &mutex));
+  }
+  workers.join_all();
+}
+
+template <class Arc>
+void Decoder::decodeWorker(const std::vector<int>& ids, std::size_t* nextId,
+                           boost::mutex* mutex) const {
+  while (true) {
+    int id;
+    {
+      boost::mutex::scoped_lock lock(*mutex);
+      if (*nextId >= ids.size()) {
+        return;
+      }
+      id = ids[*nextId];
+      ++(*nextId);
+    }
+    decodeSentence<Arc>(id);
+  }
+}
+
+template <class Arc>
+void Decoder::decodeSentence(const int id) const {
+  LOG(INFO)<< "Processing sentence number " << id;
+  SentenceData data;
+  load(id, &data);
+  boost::shared_ptr<Lattice<Arc> > lattice = search<Arc>(data);
+  write(id, lattice.get());
+}
+
+template <class Arc>
+boost::shared_ptr<Lattice<Arc> > Decoder::search(
+    const SentenceData& data) const {
+  const std::vector<int>& inputSentence = inputSentences_[data.id - 1];
+  const std::vector<int>& splitPositions = data.splitPositions;
+  const int id = data.id;
+  boost::shared_ptr<Lattice<Arc> > lattice(new Lattice<Arc>(
+      inputSentence, data.languageModel, featureSet_,
+      data.futureCosts, lmTransitionCacheSize_, releaseColumns_, lazyFst_));
   CHECK(!splitPositions.empty()) << "Split positions are empty, there should be"
       " at least one element which is the size of the input sentence.";
   int chunkId = 0;
   int splitPosition = splitPositions[0];
+  // chunks are used strictly in order, so a chunk is only needed from its
+  // first column to its last column.
+  data.ngramLoader->loadChunk(chunkId);
   int pruneNbest = 0;
   if (pruneNbest_ != 0) {
     pruneNbest = pruneNbest_;
@@ -176,6 +415,7 @@ void Decoder::decode(
   }
   for (int i = 0; i < inputSentence.size(); ++i) {
     if (i >= splitPosition) {
+      data.ngramLoader->releaseChunk(chunkId);
       ++chunkId;
       // because the last split position is inputSentence.size(), we know that
       // splitPositions[chunkId] exists.
@@ -183,21 +423,62 @@ void Decoder::decode(
           " should be less than the size of the split positions: " <<
           splitPositions.size() << " in sentence id " << id;
       splitPosition = splitPositions[chunkId];
+      data.ngramLoader->loadChunk(chunkId);
     }
-    lattice->extend(ngramLoader, i, pruneNbest, pruneThreshold_, overlap_,
-                    chunkId, allowDeletion_);
+    lattice->extend(*data.ngramLoader, i, pruneNbest, pruneThreshold_,
+                    overlap_, chunkId, allowDeletion_, extendThreads_);
   }
+  data.ngramLoader->releaseChunk(chunkId);
   lattice->markFinalStates(inputSentence.size());
+  lattice->logLmCacheStatistics();
   if (addInput_) {
     lattice->addInput();
   }
   if (whenLostInput_) {
     lattice->whenLostInput();
   }
+  return lattice;
+}
+
+template <class Arc>
+void Decoder::write(const int id, Lattice<Arc>* lattice) const {
   lattice->compactFst(dumpPrune_);
+  writeCompacted(id, *lattice);
+}
+
+template <class Arc>
+void Decoder::writeCompacted(const int id, const Lattice<Arc>& lattice) const {
   std::ostringstream output;
   output << fstOutput_ << "/" << id << ".fst";
-  lattice->write(output.str());
+  lattice.write(output.str());
+}
+
+template <class Arc>
+void Decoder::searchStage(
+    BoundedQueue<boost::shared_ptr<SentenceData> >* loaded,
+    BoundedQueue<SearchedSentence<Arc> >* searched) const {
+  boost::shared_ptr<SentenceData> data;
+  while (loaded->pop(&data)) {
+    LOG(INFO)<< "Processing sentence number " << data->id;
+    SearchedSentence<Arc> searchedSentence;
+    searchedSentence.id = data->id;
+    searchedSentence.lattice = search<Arc>(*data);
+    // release the n-grams before compacting and waiting on the queue. The
+    // language model is still referenced by the lattice.
+    data.reset();
+    searchedSentence.lattice->compactFst(dumpPrune_);
+    searched->push(searchedSentence);
+  }
+}
+
+template <class Arc>
+void Decoder::writeStage(
+    BoundedQueue<SearchedSentence<Arc> >* searched) const {
+  SearchedSentence<Arc> searchedSentence;
+  while (searched->pop(&searchedSentence)) {
+    writeCompacted(searchedSentence.id, *searchedSentence.lattice);
+    searchedSentence.lattice.reset();
+  }
 }
 
 } // namespace gen
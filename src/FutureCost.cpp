@@ -0,0 +1,97 @@
+/*
+ * FutureCost.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "FutureCost.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Util.h"
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+void unigramFutureCosts(const std::vector<int>& inputSentence,
+                        const LanguageModel& languageModel,
+                        std::vector<Cost>* futureCosts) {
+  futureCosts->assign(inputSentence.size(), 0);
+  lm::ngram::State nullState(languageModel.NullContextState()), endState;
+  for (int i = 0; i < inputSentence.size(); ++i) {
+    if (inputSentence[i] != STARTSENTENCE && inputSentence[i] != ENDSENTENCE) {
+      (*futureCosts)[i] = languageModel.Score(
+          nullState, languageModel.index(inputSentence[i]), endState) *
+              (-log(10));
+    }
+  }
+}
+
+void ngramFutureCosts(const std::vector<int>& inputSentence,
+                      const NgramLoader& ngramLoader,
+                      const LanguageModel& languageModel,
+                      const bool allowDeletion,
+                      std::vector<Cost>* futureCosts) {
+  const int sentenceSize = inputSentence.size();
+  const Cost infinity = std::numeric_limits<Cost>::infinity();
+  futureCosts->assign(sentenceSize, infinity);
+  std::vector<Cost> wordCosts;
+  Coverage coverage;
+  for (int chunkId = 0; chunkId < ngramLoader.numChunks(); ++chunkId) {
+    const NgramTable& ngrams = ngramLoader.ngrams(chunkId);
+    for (int n = 0; n < ngrams.size(); ++n) {
+      const int* ngram = ngrams.words(n);
+      const lm::WordIndex* kenlmIndices = ngrams.kenlmIndices(n);
+      const int ngramSize = ngrams.ngramSize(n);
+      // cost of each word of the n-gram: language model score with the
+      // history within the n-gram plus the cheapest share of the feature
+      // cost over the offsets that apply the word.
+      wordCosts.resize(ngramSize);
+      lm::ngram::State state(ngrams.startsWithStart(n) ?
+          languageModel.BeginSentenceState() :
+          languageModel.NullContextState()), nextState;
+      Cost featureShare = infinity;
+      for (int j = 0; j < ngramSize; ++j) {
+        featureShare = std::min(featureShare,
+                                ngrams.cost(n, j) / (ngramSize - j));
+        wordCosts[j] = featureShare;
+        if (j > 0 || !ngrams.startsWithStart(n)) {
+          wordCosts[j] += languageModel.Score(
+              state, kenlmIndices[j], nextState) * (-log(10));
+          state = nextState;
+        }
+      }
+      if (allowDeletion && ngram[ngramSize - 1] != STARTSENTENCE &&
+          !ngrams.endsWithEnd(n)) {
+        wordCosts.back() = std::min(wordCosts.back(), ngrams.deletionCost(n));
+      }
+      // a word of the n-gram covers the positions of the coverage that hold
+      // the same word.
+      for (int c = ngrams.coverageBegin(n); c < ngrams.coverageEnd(n); ++c) {
+        ngrams.coverage(c, &coverage);
+        for (std::size_t bit = coverage.findFirst(); bit != Coverage::npos;
+            bit = coverage.findNext(bit)) {
+          const int position = sentenceSize - 1 - bit;
+          Cost& futureCost = (*futureCosts)[position];
+          for (int j = 0; j < ngramSize; ++j) {
+            if (ngram[j] == inputSentence[position]) {
+              futureCost = std::min(futureCost, wordCosts[j]);
+            }
+          }
+        }
+      }
+    }
+  }
+  for (int i = 0; i < sentenceSize; ++i) {
+    if ((*futureCosts)[i] == infinity) {
+      (*futureCosts)[i] = 0;
+    }
+  }
+}
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
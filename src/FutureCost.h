@@ -0,0 +1,63 @@
+/*
+ * FutureCost.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef FUTURECOST_H_
+#define FUTURECOST_H_
+
+#include <vector>
+
+#include "LanguageModel.h"
+#include "NgramLoader.h"
+#include "Types.h"
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+/**
+ * Estimates the future cost of each input word with a unigram language model:
+ * the cost of a word is its unigram probability. Sentence markers have no
+ * cost.
+ * @param inputSentence The input sentence.
+ * @param languageModel The language model. Scoring from the null context gives
+ * the unigram probability, whether the model is a unigram model or not.
+ * @param futureCosts The resulting cost of each input position.
+ */
+void unigramFutureCosts(const std::vector<int>& inputSentence,
+                        const LanguageModel& languageModel,
+                        std::vector<Cost>* futureCosts);
+
+/**
+ * Estimates the future cost of each input word from the n-grams of the
+ * sentence. An n-gram covering a word contributes the language model cost of
+ * that word with the history available within the n-gram plus an equal share
+ * of the n-gram feature cost, and the estimate of a position is the cheapest
+ * contribution over all n-grams, offsets (in case of overlap) and deletions
+ * that can cover it. Positions that no n-gram covers have no cost.
+ * This is a heuristic, not an admissible bound: during the search the word
+ * may be scored with a longer history across n-gram boundaries, which can be
+ * cheaper than its score within the n-gram, and the equal shares of the
+ * feature cost are not a lower bound when feature weights are negative. It
+ * is therefore neither always optimistic nor always tighter than the unigram
+ * estimate, and pruning with it may discard hypotheses that the unigram
+ * estimate would keep.
+ * @param inputSentence The input sentence.
+ * @param ngramLoader The n-grams of every chunk of the sentence.
+ * @param languageModel The language model.
+ * @param allowDeletion Whether unigrams may be deleted.
+ * @param futureCosts The resulting cost of each input position.
+ */
+void ngramFutureCosts(const std::vector<int>& inputSentence,
+                      const NgramLoader& ngramLoader,
+                      const LanguageModel& languageModel,
+                      const bool allowDeletion,
+                      std::vector<Cost>* futureCosts);
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
+
+#endif /* FUTURECOST_H_ */
@@ -0,0 +1,132 @@
+/*
+ * LanguageModel.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "LanguageModel.h"
+
+#include <algorithm>
+#include <glog/logging.h>
+#include <lm/enumerate_vocab.hh>
+
+#include "Util.h"
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+namespace {
+
+/**
+ * Collects the KenLM index of every word of the vocabulary that is one of our
+ * integer ids or a sentence marker.
+ */
+class IdEnumerator : public lm::EnumerateVocab {
+public:
+  /**
+   * Constructor.
+   * @param ids The (id, KenLM index) pairs to fill.
+   */
+  explicit IdEnumerator(std::vector<std::pair<int, lm::WordIndex> >* ids) :
+      ids_(ids) {}
+
+  void Add(lm::WordIndex index, const StringPiece& str) {
+    int id;
+    if (str == StringPiece("<s>")) {
+      id = STARTSENTENCE;
+    } else if (str == StringPiece("</s>")) {
+      id = ENDSENTENCE;
+    } else if (!parseId(str, &id) || id == STARTSENTENCE ||
+        id == ENDSENTENCE) {
+      // the ids of the sentence markers are always mapped to the markers.
+      return;
+    }
+    ids_->push_back(std::make_pair(id, index));
+  }
+
+private:
+  /**
+   * Parses a word as an id. Only the canonical decimal representation, which
+   * is the one written by our wordmap, is accepted.
+   * @param str The word.
+   * @param id The resulting id.
+   * @return True if the word is an id.
+   */
+  static bool parseId(const StringPiece& str, int* id) {
+    if (str.size() == 0 || str.size() > 9 ||
+        (str.size() > 1 && str.data()[0] == '0')) {
+      return false;
+    }
+    *id = 0;
+    for (std::size_t i = 0; i < str.size(); ++i) {
+      char c = str.data()[i];
+      if (c < '0' || c > '9') {
+        return false;
+      }
+      *id = *id * 10 + (c - '0');
+    }
+    return true;
+  }
+
+  std::vector<std::pair<int, lm::WordIndex> >* ids_;
+};
+
+} // namespace
+
+LanguageModel::LanguageModel(const std::string& fileName,
+                             lm::ngram::Config config) {
+  std::vector<std::pair<int, lm::WordIndex> > ids;
+  IdEnumerator enumerator(&ids);
+  config.enumerate_vocab = &enumerator;
+  model_.reset(new lm::ngram::Model(fileName.c_str(), config));
+  CHECK(!ids.empty()) << "The vocabulary of the language model " <<
+      fileName << " could not be enumerated";
+  notFound_ = model_->GetVocabulary().NotFound();
+  // ids from our wordmap are dense, but a stray numeric token, e.g. a number
+  // in the training data, must not size the table. The table covers ids up to
+  // twice the number of ids in the vocabulary and the others go to a hash
+  // map. The sentence markers always have an entry: a model used only for
+  // future costs, e.g. a unigram model, may not contain them.
+  const int maxDenseId = std::max<int>(ENDSENTENCE, 2 * ids.size());
+  int denseSize = ENDSENTENCE + 1;
+  for (int i = 0; i < ids.size(); ++i) {
+    if (ids[i].first <= maxDenseId) {
+      denseSize = std::max(denseSize, ids[i].first + 1);
+    }
+  }
+  // ids between the ids found in the vocabulary are unknown words.
+  indices_.assign(denseSize, notFound_);
+  for (int i = 0; i < ids.size(); ++i) {
+    if (ids[i].first < denseSize) {
+      indices_[ids[i].first] = ids[i].second;
+    } else {
+      sparseIndices_[ids[i].first] = ids[i].second;
+    }
+  }
+  if (!sparseIndices_.empty()) {
+    LOG(INFO) << sparseIndices_.size() << " ids of the language model " <<
+        fileName << " are out of the dense range [0, " << denseSize << ")";
+  }
+}
+
+lm::WordIndex LanguageModel::sparseIndex(const int id) const {
+  if (sparseIndices_.empty()) {
+    return notFound_;
+  }
+  boost::unordered_map<int, lm::WordIndex>::const_iterator it =
+      sparseIndices_.find(id);
+  return it == sparseIndices_.end() ? notFound_ : it->second;
+}
+
+void LanguageModel::indices(const std::vector<int>& ids,
+                            std::vector<lm::WordIndex>* indices) const {
+  indices->resize(ids.size());
+  for (int i = 0; i < ids.size(); ++i) {
+    (*indices)[i] = index(ids[i]);
+  }
+}
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
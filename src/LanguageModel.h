@@ -0,0 +1,116 @@
+/*
+ * LanguageModel.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef LANGUAGEMODEL_H_
+#define LANGUAGEMODEL_H_
+
+#include <string>
+#include <vector>
+#include <boost/smart_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <lm/model.hh>
+
+#include "Util.h"
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+/**
+ * A KenLM language model together with a dense table from our integer word
+ * ids to KenLM vocabulary indices. The table is built once when the model is
+ * loaded, by enumerating the vocabulary, so that scoring never converts ids to
+ * strings. The table is bounded by the size of the vocabulary; the few ids
+ * beyond it are looked up in a hash map.
+ */
+class LanguageModel {
+public:
+  /**
+   * Constructor. Loads the model and builds the id to index table.
+   * @param fileName The language model file name, in ARPA or KenLM binary
+   * format.
+   * @param config The KenLM configuration. Its vocabulary enumeration callback
+   * is overridden.
+   */
+  LanguageModel(const std::string& fileName, lm::ngram::Config config);
+
+  /**
+   * Gets the KenLM index of a word id.
+   * @param id The id corresponding to a word via our own wordmap.
+   * @return The index in the KenLM vocabulary, the unknown word index if the
+   * id is not in the language model.
+   */
+  lm::WordIndex index(const int id) const {
+    return (id >= 0 && id < indices_.size()) ? indices_[id] : sparseIndex(id);
+  }
+
+  /**
+   * Gets the KenLM indices of a sequence of word ids.
+   * @param ids The ids.
+   * @param indices The resulting indices.
+   */
+  void indices(const std::vector<int>& ids,
+               std::vector<lm::WordIndex>* indices) const;
+
+  /**
+   * Checks if the end-of-sentence marker is in the vocabulary. It is needed
+   * by the language model that scores the hypotheses, not by a language model
+   * only used to estimate future costs.
+   * @return True if </s> is in the vocabulary.
+   */
+  bool hasEndSentence() const {
+    return indices_[ENDSENTENCE] != notFound_;
+  }
+
+  /**
+   * Getter.
+   * @return The KenLM model.
+   */
+  const lm::ngram::Model& model() const {
+    return *model_;
+  }
+
+  unsigned char Order() const {
+    return model_->Order();
+  }
+
+  lm::ngram::State BeginSentenceState() const {
+    return model_->BeginSentenceState();
+  }
+
+  lm::ngram::State NullContextState() const {
+    return model_->NullContextState();
+  }
+
+  float Score(const lm::ngram::State& in, const lm::WordIndex index,
+              lm::ngram::State& out) const {
+    return model_->Score(in, index, out);
+  }
+
+private:
+  /**
+   * Gets the KenLM index of a word id out of the dense table.
+   * @param id The id.
+   * @return The index in the KenLM vocabulary, the unknown word index if the
+   * id is not in the language model.
+   */
+  lm::WordIndex sparseIndex(const int id) const;
+
+  /** The KenLM model. */
+  boost::scoped_ptr<lm::ngram::Model> model_;
+  /** KenLM index for each word id in the dense range. */
+  std::vector<lm::WordIndex> indices_;
+  /** KenLM index for the ids of the vocabulary beyond the dense range. */
+  boost::unordered_map<int, lm::WordIndex> sparseIndices_;
+  /** KenLM index of the unknown word. */
+  lm::WordIndex notFound_;
+};
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
+
+#endif /* LANGUAGEMODEL_H_ */
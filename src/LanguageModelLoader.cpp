@@ -0,0 +1,106 @@
+/*
+ * LanguageModelLoader.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "LanguageModelLoader.h"
+
+#include <iomanip>
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include <boost/cstdint.hpp>
+#include <glog/logging.h>
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+namespace {
+
+/**
+ * FNV-1a hash. Used instead of boost::hash so that cache file names do not
+ * change between builds.
+ * @param s The string to hash.
+ * @return The hash value.
+ */
+boost::uint64_t fnv1a(const std::string& s) {
+  boost::uint64_t res = 14695981039346656037ULL;
+  for (int i = 0; i < s.size(); ++i) {
+    res ^= static_cast<unsigned char>(s[i]);
+    res *= 1099511628211ULL;
+  }
+  return res;
+}
+
+} // namespace
+
+LanguageModelLoader::LanguageModelLoader(const std::string& cacheDirectory,
+                                         const std::string& loadMethod) :
+    cacheDirectory_(cacheDirectory) {
+  if (loadMethod == "lazy") {
+    loadMethod_ = util::LAZY;
+  } else if (loadMethod == "populate") {
+    loadMethod_ = util::POPULATE_OR_READ;
+  } else if (loadMethod == "read") {
+    loadMethod_ = util::READ;
+  } else {
+    LOG(FATAL) << "Unknown language model load method: " << loadMethod <<
+        ". The load method can only be 'lazy', 'populate' or 'read'";
+  }
+  if (!cacheDirectory_.empty()) {
+    boost::filesystem::create_directories(cacheDirectory_);
+  }
+}
+
+boost::shared_ptr<LanguageModel> LanguageModelLoader::load(
+    const std::string& fileName) const {
+  lm::ngram::Config config;
+  config.load_method = loadMethod_;
+  lm::ngram::ModelType modelType;
+  if (cacheDirectory_.empty() ||
+      lm::ngram::RecognizeBinary(fileName.c_str(), modelType)) {
+    return boost::shared_ptr<LanguageModel>(
+        new LanguageModel(fileName, config));
+  }
+  std::string cached = cachedFileName(fileName);
+  if (boost::filesystem::exists(cached)) {
+    VLOG(1) << "Loading cached binary language model " << cached << " for "
+        << fileName;
+    return boost::shared_ptr<LanguageModel>(
+        new LanguageModel(cached, config));
+  }
+  // the binary file is written to a temporary file first and then renamed so
+  // that concurrent loads of the same language model never see a partially
+  // written file.
+  std::string temporary = cached + "." +
+      boost::filesystem::unique_path("%%%%-%%%%-%%%%").string();
+  config.write_mmap = temporary.c_str();
+  boost::shared_ptr<LanguageModel> res;
+  try {
+    res.reset(new LanguageModel(fileName, config));
+  } catch (...) {
+    // a partially written binary file is not left in the cache directory.
+    boost::system::error_code error;
+    boost::filesystem::remove(temporary, error);
+    throw;
+  }
+  boost::filesystem::rename(temporary, cached);
+  LOG(INFO) << "Cached binary language model " << cached << " for " <<
+      fileName;
+  return res;
+}
+
+std::string LanguageModelLoader::cachedFileName(
+    const std::string& fileName) const {
+  boost::filesystem::path path = boost::filesystem::absolute(fileName);
+  std::ostringstream res;
+  res << cacheDirectory_ << "/" << std::hex << std::setw(16) <<
+      std::setfill('0') << fnv1a(path.string()) << std::dec << "_" <<
+      boost::filesystem::last_write_time(path) << ".binlm";
+  return res.str();
+}
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
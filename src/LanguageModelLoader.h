@@ -0,0 +1,67 @@
+/*
+ * LanguageModelLoader.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef LANGUAGEMODELLOADER_H_
+#define LANGUAGEMODELLOADER_H_
+
+#include <string>
+#include <boost/smart_ptr.hpp>
+#include <lm/model.hh>
+#include <util/mmap.hh>
+
+#include "LanguageModel.h"
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+/**
+ * Loads KenLM language models, possibly through a persistent cache of KenLM
+ * binary files. Language models in ARPA format are converted to binary format
+ * the first time they are loaded, and the binary file is memory mapped on
+ * subsequent loads. Cache entries are keyed by the language model path and its
+ * modification time so that a modified language model is converted again.
+ */
+class LanguageModelLoader {
+public:
+  /**
+   * Constructor.
+   * @param cacheDirectory Directory containing the cached binary language
+   * models. If empty, language models are loaded directly without caching.
+   * @param loadMethod How binary language models are loaded: "lazy" (memory
+   * map and page in on demand), "populate" (memory map and prefault) or "read"
+   * (read into allocated memory).
+   */
+  LanguageModelLoader(const std::string& cacheDirectory,
+                      const std::string& loadMethod);
+
+  /**
+   * Loads a language model. This method may be called concurrently.
+   * @param fileName The language model file name, in ARPA or KenLM binary
+   * format.
+   * @return The language model.
+   */
+  boost::shared_ptr<LanguageModel> load(const std::string& fileName) const;
+
+private:
+  /**
+   * Computes the name of the cached binary file for a language model.
+   * @param fileName The language model file name.
+   * @return The cached binary file name.
+   */
+  std::string cachedFileName(const std::string& fileName) const;
+
+  /** Directory containing the cached binary language models. */
+  std::string cacheDirectory_;
+  /** How binary language models are loaded. */
+  util::LoadMethod loadMethod_;
+};
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
+
+#endif /* LANGUAGEMODELLOADER_H_ */
@@ -8,20 +8,29 @@
 #ifndef LATTICE_H_
 #define LATTICE_H_
 
+#include <algorithm>
 #include <vector>
+#include <boost/bind.hpp>
 #include <boost/smart_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/unordered_map.hpp>
 #include <fst/fstlib.h>
 #include <lm/model.hh>
 #include <lm/state.hh>
 
+#include "Arena.h"
+#include "CandidateIndex.h"
 #include "Column.h"
+#include "LanguageModel.h"
+#include "LmCache.h"
 #include "features/RuleCostComputer.h"
-#include "features/Weights.h"
+#include "features/FeatureSet.h"
 #include "NgramLoader.h"
 #include "State.h"
 #include "StateKey.h"
 #include "Types.h"
 #include "Util.h"
+#include "WorkerPool.h"
 
 namespace cam {
 namespace eng {
@@ -43,16 +52,23 @@ public:
    * an initial state and adds it to the lattice.
    * @param words The input words to be reordered.
    * @param languageModel The language model.
-   * @param featureNames The feature names.
-   * @param weights The feature weights.
-   * @param futureCostLanguageModel Unigram language model to estimate the
-   * future cost. The unigram language model is applied to the words not yet
-   * covered.
+   * @param featureSet The features and their weights.
+   * @param futureCosts Estimated cost of each input word, applied to the
+   * words not yet covered. If empty, no future cost is estimated.
+   * @param lmCacheSize Number of language model transitions cached by each
+   * thread extending states. Zero disables the cache.
+   * @param releaseColumns Whether the states of a column are released as soon
+   * as the column is extended, so that only the columns not yet extended are
+   * kept in memory.
+   * @param lazyFst Whether the search only records back edges between
+   * hypotheses, the fst being built by markFinalStates from the hypotheses
+   * that reach the last column.
    */
   Lattice(const std::vector<int>& words,
-          boost::shared_ptr<lm::ngram::Model> languageModel,
-          const std::vector<std::string>& featureNames, const Weights& weights,
-          const boost::shared_ptr<lm::ngram::Model>& futureCostLanguageModel);
+          boost::shared_ptr<LanguageModel> languageModel,
+          boost::shared_ptr<FeatureSet> featureSet,
+          const std::vector<Cost>& futureCosts, const int lmCacheSize,
+          const bool releaseColumns, const bool lazyFst);
 
   /**
    * Destructor. Custom destructor because one field is a pointer.
@@ -71,15 +87,23 @@ public:
    * coverage
    * @param chunkId The chunk id for the chunk we are decoding in case the input
    * sentences is chopped into multiple parts (for speed and memory).
+   * @param allowDeletion Whether unigrams are allowed to be deleted.
+   * @param numThreads Number of threads used to expand the states in the
+   * column. Each thread expands a disjoint slice of the states and the
+   * resulting extensions are then added to the lattice in the same order as
+   * with one thread, so the result does not depend on the number of threads.
+   * The threads are started at the first column and reused for the others.
+   * Columns with few states are expanded by the calling thread only.
+   * If columns are released, the column is released once extended.
    */
   void extend(const NgramLoader& ngramLoader, const int columnIndex,
               const int pruneNbest, const float pruneThreshold,
               const int maxOverlap, const int chunkId,
-              const bool allowDeletion);
+              const bool allowDeletion, const int numThreads);
 
   /**
    * Set final states for states that are in the column indexed by the length
-   * of the input.
+   * of the input. With a lazy fst, the fst is built at this point.
    * @param length The length of the input
    */
   void markFinalStates(const int length);
@@ -91,7 +115,9 @@ public:
   void addInput();
 
   /**
-   * Applies fst operations to get a compact fst, including pruning.
+   * Applies fst operations to get a compact fst, including pruning. The
+   * lattice is acyclic so fst::Minimize, which computes this property, uses
+   * its linear time acyclic minimization.
    * @param pruneWeight The pruning threshold.
    */
   void compactFst(const float pruneWeight);
@@ -107,60 +133,239 @@ public:
    */
   void whenLostInput() const;
 
+  /**
+   * Logs the hit rate of the language model transition caches.
+   */
+  void logLmCacheStatistics() const;
+
 private:
   /**
    * In case of overlap, checks if the history of a state is compatible with an
    * n-gram.
    * @param state The state to be potentially extended with n-gram.
-   * @param ngram The n-gram used to potentially extend the state.
+   * @param words The words of the n-gram used to potentially extend the
+   * state.
+   * @param kenlmIndices The KenLM indices of the words of the n-gram.
    * @param overlap The overlap between the n-gram coverage and the
    * state coverage
    * @param overlapCount The number of bits set in overlap.
    * @return True if the history of the state is compatible with the n-gram.
+   * The overlap is limited to the length of the KenLM state, which KenLM
+   * minimizes: the words beyond it are not part of the history and are not
+   * compared.
    */
-  bool compatibleHistory(const State& state, const Ngram& ngram,
+  bool compatibleHistory(const State& state, const int* words,
+                         const lm::WordIndex* kenlmIndices,
                          const Coverage& overlap, const int overlapCount) const;
 
   /**
    * Checks if an n-gram with a certain coverage can extend a state.
    * Conditions are coverage compatibility and start/end-of-sentence markers.
    * @param state The state to be extended.
-   * @param ngram The n-gram extending the current state.
-   * @param coverage The coverage of the n-gram.
+   * @param ngrams The n-grams of the chunk.
+   * @param ngram The index of the n-gram extending the current state.
+   * @param coverage The index of the coverage of the n-gram.
    * @param maxOverlap The maximum overlap between state coverage and n-gram
    * coverage.
-   * @param ngramToApply The n-gram to be applied to the state. This n-gram is
-   * truncated if there is a non trivial overlap.
+   * @param overlap The number of words of the n-gram overlapping the state
+   * coverage. These words are not applied to the state.
    * @return True if the state can be extended with the n-gram and coverage.
    */
-  bool canApply(const State& state, const Ngram& ngram,
-                const Coverage& coverage, const int maxOverlap,
-                Ngram* ngramToApply) const;
+  bool canApply(const State& state, const NgramTable& ngrams, const int ngram,
+                const int coverage, const int maxOverlap, int* overlap) const;
+
+  /**
+   * Result of extending a state with an n-gram (or a deletion). Extensions
+   * only depend on the state being extended so they can be computed in
+   * parallel before being added to the lattice.
+   */
+  struct Extension {
+    /** The state being extended. */
+    const State* state;
+    /** The n-gram applied to the state (truncated in case of overlap). */
+    Ngram ngram;
+    /** The KenLM indices of the words of the n-gram applied. They point to
+     * the n-gram loader. */
+    const lm::WordIndex* kenlmIndices;
+    /** The coverage of the next state. */
+    Coverage coverage;
+    /** The history of the next state. */
+    lm::ngram::State kenlmState;
+    /** The cost of the next state, including its future cost. */
+    Cost cost;
+    /** The future cost of the next state. */
+    Cost futureCost;
+    /** The weight to put on the arc carrying the n-gram cost. */
+    Weight weight;
+    /** Whether the next state contains a hypothesis corresponding to the
+     * partial input. */
+    bool hasInput;
+    /** Whether the unigram is deleted, i.e. an epsilon arc is added. */
+    bool deletion;
+    /** The hash of the state key of the next state. */
+    std::size_t hash;
+  };
+
+  /**
+   * Extensions computed by one thread. Extensions are kept between columns and
+   * overwritten so that their n-gram and coverage memory is reused.
+   */
+  struct ExtensionBuffer {
+    ExtensionBuffer() : size(0) {}
+
+    /**
+     * Gets the next extension to fill in.
+     * @return The next extension.
+     */
+    Extension* add() {
+      if (size == extensions.size()) {
+        extensions.push_back(Extension());
+      }
+      return &extensions[size++];
+    }
+
+    /** Extensions, only the first size ones are valid. */
+    std::vector<Extension> extensions;
+    /** Number of valid extensions. */
+    int size;
+  };
 
   /**
-   * Extends a state with an n-gram.
+   * Computes all the extensions of a slice of states.
+   * @param states The states to be extended.
+   * @param begin The index of the first state of the slice.
+   * @param end The index after the last state of the slice.
+   * @param candidates The index over the n-grams used to extend the states.
+   * @param maxOverlap The maximum overlap between state coverage and n-gram
+   * coverage.
+   * @param allowDeletion Whether unigrams are allowed to be deleted.
+   * @param extensions The buffer receiving the resulting extensions, in the
+   * order in which they must be added to the lattice.
+   * @param lmCache The language model transition cache of the thread.
+   */
+  void expandStates(
+      const std::vector<const State*>& states, const int begin, const int end,
+      const CandidateIndex& candidates, const int maxOverlap,
+      const bool allowDeletion, ExtensionBuffer* extensions,
+      LmCache* lmCache) const;
+
+  /**
+   * Computes the extension of a state with an n-gram.
    * @param state The state to be extended.
-   * @param ngram The n-gram used to extend the state.
+   * @param ngram The n-gram used to extend the state, i.e. the n-gram of the
+   * table from the offset.
+   * @param ngrams The n-grams of the chunk, with precomputed indices and costs.
+   * @param ngramIndex The index of the n-gram in the table.
+   * @param offset The number of words of the n-gram of the table not applied
+   * because of an overlap.
    * @param coverage The coverage of the n-gram.
-   * @param pruneNbest The maximum number of states in a column.
-   * @param pruneThreshold The beam threshold pruning parameter.
+   * @param lmCache The language model transition cache of the thread.
+   * @param extension The resulting extension.
    */
-  void extend(const State& state, const Ngram& ngram,
-              const Coverage& coverage, const int pruneNbest,
-              const float pruneThreshold);
+  void computeExtension(const State& state, const Ngram& ngram,
+                        const NgramTable& ngrams, const int ngramIndex,
+                        const int offset, const Coverage& coverage,
+                        LmCache* lmCache, Extension* extension) const;
 
   /**
-   * Extends a state with a unigram and deletes it, i.e. adds an epsilon arc
-   * in the fst.
+   * Computes the extension of a state with a unigram that is deleted, i.e.
+   * an epsilon arc in the fst.
    * @param state The state to be extended.
-   * @param unigram The unigram used to extend the state.
+   * @param unigram The unigram used to extend the state, i.e. the last word
+   * of the n-gram of the table.
+   * @param ngrams The n-grams of the chunk, with precomputed costs.
+   * @param ngramIndex The index of the n-gram in the table.
    * @param coverage The coverage of the unigram.
+   * @param extension The resulting extension.
+   */
+  void computeDeletion(const State& state, const Ngram& unigram,
+                       const NgramTable& ngrams, const int ngramIndex,
+                       const Coverage& coverage, Extension* extension) const;
+
+  /**
+   * Adds an extension to the lattice: either recombines with an existing
+   * state or creates a new state, subject to pruning.
+   * @param extension The extension.
    * @param pruneNbest The maximum number of states in a column.
    * @param pruneThreshold The beam threshold pruning parameter.
    */
-  void extendDeletion(const State& state, const Ngram& unigram,
-                      const Coverage& coverage, const int pruneNbest,
-                      const float pruneThreshold);
+  void addExtension(const Extension& extension, const int pruneNbest,
+                    const float pruneThreshold);
+
+  /**
+   * Keeps only the n best states of a column and releases the other states.
+   * @param column The column.
+   * @param pruneNbest The number of states to keep.
+   */
+  void prune(Column* column, const int pruneNbest);
+
+  /**
+   * Releases the states of a column that has been extended. Only whether the
+   * column contained the partial input is kept, and the initial state is
+   * kept for addInput. The memory of the states is reused for the states of
+   * the next columns.
+   * @param columnIndex The index of the column.
+   */
+  void releaseColumn(const int columnIndex);
+
+  /**
+   * Checks if a column contains a hypothesis corresponding to the partial
+   * input, whether it has been released or not.
+   * @param columnIndex The index of the column.
+   * @return True if a state of the column has the partial input.
+   */
+  bool columnHasInput(const int columnIndex) const;
+
+  /**
+   * Adds the fst states and arcs for an extension ending in a new state.
+   * @param extension The extension.
+   * @return The state id of the last state created.
+   */
+  StateId addFstNewState(const Extension& extension);
+
+  /**
+   * With a lazy fst, records the back edge of an extension.
+   * @param extension The extension.
+   * @param node The node of the state the extension ends in.
+   */
+  void addBackEdge(const Extension& extension, const StateId node);
+
+  /**
+   * With a lazy fst, creates a node for a new hypothesis.
+   * @return The node, used as state id of the hypothesis.
+   */
+  StateId addNode();
+
+  /**
+   * With a lazy fst, builds the fst from the back edges of the nodes that
+   * reach a state of the final column, and releases the back edges.
+   * @param finalColumn The final column.
+   */
+  void buildFst(const Column& finalColumn);
+
+  /**
+   * Adds the arcs of an n-gram between two fst states, with intermediate
+   * states if the n-gram is greater than a unigram. Intermediate states are
+   * shared with the n-grams applied from the same state that start with the
+   * same words. An empty n-gram is a deletion, i.e. an epsilon arc.
+   * @param from The start state.
+   * @param words The words of the n-gram.
+   * @param numWords The number of words.
+   * @param to The end state.
+   * @param weight The weight to put on the last arc.
+   */
+  void addFstArcs(const StateId from, const int* words, const int numWords,
+                  const StateId to, const Weight& weight);
+
+  /**
+   * Gets the intermediate fst state reached from a state with a word, which
+   * is shared by all the n-grams applied from the same state that start with
+   * the same words. The state and its arc are created the first time.
+   * @param from The state.
+   * @param word The word.
+   * @return The intermediate state.
+   */
+  StateId prefixState(const StateId from, const int word);
 
   /**
    * Adds states and arcs to the fst based on the start state, the end state,
@@ -225,63 +430,142 @@ private:
       const State& state, const int columnIndex, const Ngram& ngram) const;
 
   /**
-   * Compute the future cost given a coverage. A unigram LM is applied to the
-   * words not yet covered.
-   * @param coverage The coverage.
+   * Computes the future cost of the state obtained by extending a state with
+   * an n-gram: the future cost of the state minus the future cost of the
+   * words newly covered by the n-gram.
+   * @param state The state being extended.
+   * @param coverage The coverage of the n-gram.
    * @return The future cost.
    */
-  const Cost computeFutureCost(const Coverage& coverage) const;
+  const Cost computeFutureCost(const State& state,
+                               const Coverage& coverage) const;
 
   /** The fst encoding the hypotheses. */
   boost::scoped_ptr<fst::VectorFst<Arc> > fst_;
 
+  /** Owns all the states of the lattice. The states are released together
+   * with the lattice. */
+  Arena<State> states_;
+
+  /** Extensions computed for the column being extended, one buffer per
+   * thread. */
+  std::vector<ExtensionBuffer> extensions_;
+
+  /** Language model transition caches, one per thread extending states. */
+  std::vector<LmCache> lmCaches_;
+
+  /** Minimum number of states expanded by each thread. Below this, the cost
+   * of waking up a thread is not recovered. */
+  static const int kMinStatesPerSlice = 8;
+
+  /** Threads expanding the states of a column together with the calling
+   * thread, started at the first column that needs them. */
+  boost::scoped_ptr<WorkerPool> workers_;
+
+  /** Number of transitions in each language model transition cache. */
+  int lmCacheSize_;
+
+  /** States removed by the last n-best pruning. */
+  std::vector<State*> prunedStates_;
+
   /** Lattice as a vector of columns. Indices indicate how many words have been
    * covered. */
   std::vector<Column> columns_;
 
+  /** Whether columns are released once extended. */
+  bool releaseColumns_;
+
+  /** For each released column, whether it contained the partial input. */
+  std::vector<bool> releasedColumnsHaveInput_;
+
+  /** The initial state, kept when the first column is released. */
+  State* initialState_;
+
+  /**
+   * Back edge of a hypothesis with a lazy fst: an n-gram applied to a
+   * previous hypothesis.
+   */
+  struct BackEdge {
+    /** The node of the previous hypothesis. */
+    StateId from;
+    /** Position of the words of the n-gram in the word pool. */
+    int wordsBegin;
+    /** Number of words of the n-gram, zero for a deletion. */
+    int numWords;
+    /** The weight of the n-gram. */
+    Weight weight;
+    /** The previous back edge of the same node, minus one if none. */
+    int previous;
+  };
+
+  /** Whether the fst is only built once the search is done. */
+  bool lazyFst_;
+
+  /** Back edges of all the nodes. */
+  std::vector<BackEdge> backEdges_;
+
+  /** Words of the n-grams of the back edges. */
+  std::vector<int> backEdgeWords_;
+
+  /** Last back edge of each node, minus one if none. */
+  std::vector<int> lastBackEdges_;
+
+  /** Intermediate fst states of the n-grams, indexed by the previous state
+   * and the word of the arc to them: a trie of the n-gram prefixes applied
+   * from each state. All the arcs from a state are added while its column
+   * is extended, so the trie is cleared after each column. */
+  boost::unordered_map<std::pair<StateId, int>, StateId> prefixStates_;
+
   /** Language model in KenLM format. */
-  boost::shared_ptr<lm::ngram::Model> languageModel_;
+  boost::shared_ptr<LanguageModel> languageModel_;
 
   /** Input words to be reordered. */
   std::vector<int> inputWords_;
 
-  /** List of feature names. */
-  std::vector<std::string> featureNames_;
-
-  /** List of weights. */
-  Weights weights_;
+  /** Features and their weights, shared by all lattices. */
+  boost::shared_ptr<FeatureSet> featureSet_;
 
-  /** Unigram language model to estimate a future cost. The unigram language
-   * model is applied to the words not yet covered. */
-  boost::shared_ptr<lm::ngram::Model> futureCostLanguageModel_;
+  /** Future cost of each input word, indexed by coverage bit (the word at
+   * position p is at bit size - 1 - p). Empty if no future cost is
+   * estimated. */
+  std::vector<Cost> positionFutureCosts_;
 
   friend class LatticeTest;
 };
 
 template <class Arc>
 Lattice<Arc>::Lattice(const std::vector<int>& words,
-                      boost::shared_ptr<lm::ngram::Model> languageModel,
-                      const std::vector<std::string>& featureNames,
-                      const Weights& weights,
-                      const boost::shared_ptr<lm::ngram::Model>&
-                      futureCostLanguageModel) :
-    fst_(new fst::VectorFst<Arc>()), columns_(words.size() + 1),
+                      boost::shared_ptr<LanguageModel> languageModel,
+                      boost::shared_ptr<FeatureSet> featureSet,
+                      const std::vector<Cost>& futureCosts,
+                      const int lmCacheSize, const bool releaseColumns,
+                      const bool lazyFst) :
+    fst_(new fst::VectorFst<Arc>()), lmCacheSize_(lmCacheSize),
+    columns_(words.size() + 1), releaseColumns_(releaseColumns),
+    releasedColumnsHaveInput_(words.size() + 1, false), lazyFst_(lazyFst),
     languageModel_(languageModel), inputWords_(words),
-    featureNames_(featureNames), weights_(weights),
-    futureCostLanguageModel_(futureCostLanguageModel) {
+    featureSet_(featureSet),
+    // reversed so that the costs are indexed by coverage bit.
+    positionFutureCosts_(futureCosts.rbegin(), futureCosts.rend()) {
   Coverage emptyCoverage(words.size());
   // We initialize with a null context rather than a sentence begin context
   // because if we chop an input sentence, then the first word might not be a
   // sentence begin marker.
   lm::ngram::State initKenlmState(languageModel_->NullContextState());
-  StateKey* initStateKey = new StateKey(emptyCoverage, initKenlmState);
+  StateKey initStateKey(emptyCoverage, initKenlmState);
+  // with a lazy fst, the start state is also the node of the initial state.
   StateId startId = fst_->AddState();
   fst_->SetStart(startId);
-  Cost futureCost = computeFutureCost(emptyCoverage);
-  State* initState =
-      new State(startId, initStateKey, futureCost, futureCost, true);
-  columns_[0].statesIndexByStateKey_[*initStateKey] = initState;
-  columns_[0].statesSortedByCost_.insert(initState);
+  if (lazyFst_) {
+    startId = addNode();
+  }
+  Cost futureCost = 0;
+  for (int i = 0; i < positionFutureCosts_.size(); ++i) {
+    futureCost += positionFutureCosts_[i];
+  }
+  initialState_ = new (states_.allocate())
+      State(startId, initStateKey, futureCost, futureCost, true);
+  columns_[0].add(initialState_, hash_value(initStateKey));
 }
 
 template <class Arc>
@@ -291,64 +575,85 @@ template <class Arc>
 void Lattice<Arc>::extend(const NgramLoader& ngramLoader, const int columnIndex,
                           const int pruneNbest, const float pruneThreshold,
                           const int maxOverlap, const int chunkId,
-                          const bool allowDeletion) {
-  CHECK_EQ(columns_[columnIndex].statesIndexByStateKey_.size(),
-           columns_[columnIndex].statesSortedByCost_.size()) <<
-               "Inconsistent number of states in column " << columnIndex;
+                          const bool allowDeletion, const int numThreads) {
+  Column& column = columns_[columnIndex];
   VLOG(1) << "Number of states in column " << columnIndex << " " <<
-      columns_[columnIndex].statesSortedByCost_.size();
-  const std::map<Ngram, std::vector<Coverage> >& ngrams =
-      ngramLoader.ngrams(chunkId);
-  std::set<State*, StatePointerComparator>::const_iterator stateIt =
-      columns_[columnIndex].statesSortedByCost_.begin();
-  if (stateIt == columns_[columnIndex].statesSortedByCost_.end()) {
+      column.size();
+  if (column.empty()) {
     return;
   }
-  int numStates = 0;
-  Cost minCost = (*stateIt)->cost();
-  Cost beam = minCost + pruneThreshold;
-  while (stateIt != columns_[columnIndex].statesSortedByCost_.end()) {
-    numStates++;
-    if ((pruneNbest > 0 && numStates > pruneNbest) ||
-        (pruneThreshold > 0 && (*stateIt)->cost() > beam)) {
+  const CandidateIndex& candidates = ngramLoader.candidates(chunkId);
+  // all extensions land in columns with a higher index, so the column is
+  // complete: prune it and sort it once, then select the states to expand
+  // before adding any new state.
+  if (pruneNbest > 0) {
+    prune(&column, pruneNbest);
+  }
+  column.sort();
+  std::vector<const State*> states;
+  Cost beam = column.minCost() + pruneThreshold;
+  for (int i = 0; i < column.size(); ++i) {
+    if ((pruneNbest > 0 && states.size() >= pruneNbest) ||
+        (pruneThreshold > 0 && column.state(i)->cost() > beam)) {
       break;
     }
-    for (std::map<Ngram, std::vector<Coverage> >::const_iterator ngramIt =
-        ngrams.begin(); ngramIt != ngrams.end(); ++ngramIt) {
-      for (int i = 0; i < ngramIt->second.size(); ++i) {
-        Ngram ngramToApply;
-        if (canApply(**stateIt, ngramIt->first, ngramIt->second[i],
-                     maxOverlap, &ngramToApply)) {
-          extend(**stateIt, ngramToApply, ngramIt->second[i], pruneNbest,
-                 pruneThreshold);
-          if (allowDeletion && ngramToApply.size() == 1 &&
-              ngramToApply[0] !=STARTSENTENCE &&
-              ngramToApply[0] != ENDSENTENCE) {
-            extendDeletion(**stateIt, ngramToApply, ngramIt->second[i],
-                           pruneNbest, pruneThreshold);
-          }
-          // we break to use only the first coverage of the ngram to avoid
-          // spurious ambiguity (and therefore to have better pruning: e.g. if
-          // we keep 2 states in a column and the first two correspond to the
-          // same hypothesis)
-          break;
-        }
-      }
+    states.push_back(column.state(i));
+  }
+  int numSlices = std::max<int>(
+      1, std::min<int>(numThreads, states.size() / kMinStatesPerSlice));
+  if (extensions_.size() < numSlices) {
+    extensions_.resize(numSlices);
+  }
+  for (int i = 0; i < numSlices; ++i) {
+    extensions_[i].size = 0;
+  }
+  while (lmCaches_.size() < numSlices) {
+    lmCaches_.push_back(LmCache(lmCacheSize_));
+  }
+  if (numSlices == 1) {
+    expandStates(states, 0, states.size(), candidates, maxOverlap,
+                 allowDeletion, &extensions_[0], &lmCaches_[0]);
+  } else {
+    if (!workers_ || workers_->numWorkers() < numSlices - 1) {
+      workers_.reset(new WorkerPool(numThreads - 1));
+    }
+    std::vector<boost::function<void ()> > tasks(numSlices);
+    for (int i = 0; i < numSlices; ++i) {
+      tasks[i] = boost::bind(
+          &Lattice<Arc>::expandStates, this, boost::cref(states),
+          states.size() * i / numSlices, states.size() * (i + 1) / numSlices,
+          boost::cref(candidates), maxOverlap, allowDeletion, &extensions_[i],
+          &lmCaches_[i]);
+    }
+    workers_->run(tasks);
+  }
+  // slices are merged in order so recombination and pruning see the
+  // extensions in the same order as with a single thread.
+  for (int i = 0; i < numSlices; ++i) {
+    for (int j = 0; j < extensions_[i].size; ++j) {
+      addExtension(extensions_[i].extensions[j], pruneNbest, pruneThreshold);
     }
-    ++stateIt;
+  }
+  prefixStates_.clear();
+  // the extensions point to the states of the column, so the column is only
+  // released once they are added.
+  if (releaseColumns_) {
+    releaseColumn(columnIndex);
   }
 }
 
 template <class Arc>
 void Lattice<Arc>::markFinalStates(const int length) {
+  if (lazyFst_) {
+    buildFst(columns_[length]);
+    return;
+  }
   if (columns_[length].empty()) {
     // Failure, there are no final states
     return;
   }
-  for (std::set<State*, StatePointerComparator>::const_iterator it =
-      columns_[length].statesSortedByCost_.begin();
-      it != columns_[length].statesSortedByCost_.end(); ++it) {
-    fst_->SetFinal((*it)->stateId(), Weight::One());
+  for (int i = 0; i < columns_[length].size(); ++i) {
+    fst_->SetFinal(columns_[length].state(i)->stateId(), Weight::One());
   }
 }
 
@@ -357,8 +662,21 @@ void Lattice<Arc>::addInput() {
   lm::ngram::State endKenlmState;
   RuleCostAndWeightComputer<Arc> c;
   Weight inputWeight;
-  c.compute(**(columns_[0].statesSortedByCost_.begin()), inputWords_, weights_,
-    featureNames_, languageModel_, &endKenlmState, &inputWeight);
+  std::vector<lm::WordIndex> inputIndices;
+  languageModel_->indices(inputWords_, &inputIndices);
+  std::vector<float> inputValues(featureSet_->size());
+  PrecomputedRule input;
+  input.kenlmIndices = &inputIndices[0];
+  // the whole input is scored from the initial state.
+  input.boundary = inputWords_.size();
+  input.interiorLmScore = 0;
+  input.endKenlmState = NULL;
+  input.featureCost = featureSet_->cost(
+      inputWords_, inputValues.empty() ? NULL : &inputValues[0]);
+  input.featureValues = inputValues.empty() ? NULL : &inputValues[0];
+  Cost inputLmCost = lmCost(*initialState_, inputWords_, input,
+                            *languageModel_, &endKenlmState);
+  c.compute(inputLmCost, input, *featureSet_, &inputWeight);
   StateId id = fst_->Start();
   StateId nextId;
   for (int i = 0; i < inputWords_.size(); ++i) {
@@ -397,17 +715,8 @@ void Lattice<Arc>::write(const string& filename) const {
 
 template <class Arc>
 void Lattice<Arc>::whenLostInput() const {
-  bool hasInput = false;
   for (int columnIndex = columns_.size() - 1; columnIndex >= 0; --columnIndex) {
-    for (std::set<State*, StatePointerComparator>::const_iterator stateIt =
-        columns_[columnIndex].statesSortedByCost_.begin();
-        stateIt != columns_[columnIndex].statesSortedByCost_.end();
-        ++stateIt) {
-      if ((*stateIt)->hasInput()) {
-        hasInput = true;
-        break;
-      }
-    }
+    bool hasInput = columnHasInput(columnIndex);
     if (hasInput && columnIndex == columns_.size() - 1) {
       return;
     }
@@ -419,41 +728,59 @@ void Lattice<Arc>::whenLostInput() const {
 }
 
 template <class Arc>
-bool Lattice<Arc>::compatibleHistory(const State& state, const Ngram& ngram,
+void Lattice<Arc>::logLmCacheStatistics() const {
+  long hits = 0;
+  long misses = 0;
+  for (int i = 0; i < lmCaches_.size(); ++i) {
+    hits += lmCaches_[i].hits();
+    misses += lmCaches_[i].misses();
+  }
+  if (hits + misses > 0) {
+    LOG(INFO) << "Language model transition cache: " << hits << " hits, " <<
+        misses << " misses, hit rate " << 100.0 * hits / (hits + misses) <<
+        "%";
+  }
+}
+
+template <class Arc>
+bool Lattice<Arc>::compatibleHistory(const State& state, const int* words,
+                                     const lm::WordIndex* kenlmIndices,
                                      const Coverage& overlap,
                                      const int overlapCount) const {
   if (overlapCount == 0) {
     return true;
   }
+  // the words beyond the length of the KenLM state are stale.
+  if (overlapCount > state.getKenlmState().length) {
+    return false;
+  }
   // first check that the first words in the ngram correspond to the history
-  std::set<int> overlappingWords;
   for (int i = 0; i < overlapCount; ++i) {
-    lm::WordIndex windex = index(languageModel_->GetVocabulary(), ngram[i]);
-    if (windex != state.getKenlmState().words[overlapCount - 1 -i]) {
+    if (kenlmIndices[i] != state.getKenlmState().words[overlapCount - 1 -i]) {
       return false;
     }
-    overlappingWords.insert(ngram[i]);
   }
   // then check that the first words in the ngram correspond to the input words
-  // corresponding to the overlap bits
+  // corresponding to the overlap bits. The overlap is shorter than the history
+  // so a linear search is enough.
   int overlapSize = overlap.size();
-  for (int i = 0; i < overlapSize; ++i) {
-    if (overlap.test(i)) {
-      if (overlappingWords.find(inputWords_[overlapSize - i - 1]) ==
-          overlappingWords.end()) {
-        return false;
-      }
+  for (std::size_t bit = overlap.findFirst(); bit != Coverage::npos;
+      bit = overlap.findNext(bit)) {
+    const int word = inputWords_[overlapSize - bit - 1];
+    if (std::find(words, words + overlapCount, word) ==
+        words + overlapCount) {
+      return false;
     }
   }
   return true;
 }
 
 template <class Arc>
-bool Lattice<Arc>::canApply(const State& state, const Ngram& ngram,
-                            const Coverage& coverage, const int maxOverlap,
-                            Ngram* ngramToApply) const {
-  Coverage ol = state.coverage() & coverage;
-  int olcount = ol.count();
+bool Lattice<Arc>::canApply(const State& state, const NgramTable& ngrams,
+                            const int ngram, const int coverageIndex,
+                            const int maxOverlap, int* overlap) const {
+  int olcount =
+      state.coverage().intersectionCount(ngrams.coverageBlocks(coverageIndex));
   // olcount cannot be greater than the maximum overlap allowed (FLAGS_overlap)
   // olcount cannot be greater than the size of the history
   if (olcount > maxOverlap || olcount >= languageModel_->Order()) {
@@ -462,274 +789,395 @@ bool Lattice<Arc>::canApply(const State& state, const Ngram& ngram,
   // ol cannot be included in the current coverage otherwise we don't extend
   // anything. In the special case were ol is the empty set (for example in the
   // initial state), we don't want coverage to be the empty set either.
-  if (ol == coverage) {
+  // The coverage is included in the state coverage when all its bits overlap.
+  if (olcount == ngrams.coverageCount(coverageIndex)) {
     return false;
   }
-  // Check that the history of this state is compatible with the ngram. True
-  // if the overlap is empty.
-  if (!compatibleHistory(state, ngram, ol, olcount)) {
-    return false;
+  // Check that the history of this state is compatible with the ngram. The
+  // overlap is only built when it is not empty.
+  if (olcount > 0) {
+    Coverage overlapCoverage;
+    ngrams.coverage(coverageIndex, &overlapCoverage);
+    overlapCoverage &= state.coverage();
+    if (!compatibleHistory(state, ngrams.words(ngram),
+                           ngrams.kenlmIndices(ngram), overlapCoverage,
+                           olcount)) {
+      return false;
+    }
   }
   // check that if the ngram starts with start-of-sentence, then the current
   // state is initial (that is, has an empty coverage)
-  if (ngram[0] == STARTSENTENCE && !state.isInitial()) {
+  if (ngrams.startsWithStart(ngram) && !state.isInitial()) {
     return false;
   }
   // check that if the state is initial, then the
   // ngram has to start with a start-of-sentence.
   // This assumes an input bag of words with start and end
   // of sentence markers.
-  if (ngram[0] != STARTSENTENCE && state.isInitial()) {
+  if (!ngrams.startsWithStart(ngram) && state.isInitial()) {
     return false;
   }
   // checks that if the ngram ends with end-of-sentence, then the resulting
   // coverage will cover all words
-  if (ngram[ngram.size() - 1] == ENDSENTENCE) {
-    int sizeNextCoverage =
-        state.coverage().count() + coverage.count() - olcount;
-    if (sizeNextCoverage < coverage.size()) {
+  if (ngrams.endsWithEnd(ngram)) {
+    int sizeNextCoverage = state.coverage().count() +
+        ngrams.coverageCount(coverageIndex) - olcount;
+    if (sizeNextCoverage < state.coverage().size()) {
       return false;
     }
   }
-  // at this point, we can apply the ngram. We need to truncate it in case there
-  // is a non trivial overlap
-  *ngramToApply = ngram;
-  for (int i = 0; i < olcount; ++i) {
-    ngramToApply->erase(ngramToApply->begin());
-  }
+  // at this point, we can apply the ngram. It is truncated by the caller in
+  // case there is a non trivial overlap
+  *overlap = olcount;
   return true;
 }
 
 template <class Arc>
-void Lattice<Arc>::extend(const State& state, const Ngram& ngram,
-                          const Coverage& coverage, const int pruneNbest,
-                          const float pruneThreshold) {
-  Coverage newCoverage = state.coverage() | coverage;
-  int columnIndex = newCoverage.count();
-  lm::ngram::State* nextKenlmState = new lm::ngram::State();
-  Weight arcWeight;
-  RuleCostAndWeightComputer<Arc> ruleCostAndWeightComputer;
-  Cost applyNgramCost = ruleCostAndWeightComputer.compute(
-      state, ngram, weights_, featureNames_, languageModel_,
-      nextKenlmState, &arcWeight);
-  Cost newFutureCost = computeFutureCost(newCoverage);
-  Cost newCost =
-      state.cost() - state.futureCost() + applyNgramCost + newFutureCost;
-  StateKey* newStateKey = new StateKey(newCoverage, *nextKenlmState);
-  delete nextKenlmState;
-  State* newState;
-  boost::unordered_map<StateKey, State*>::const_iterator findNewStateKey =
-      columns_[columnIndex].statesIndexByStateKey_.find(*newStateKey);
-  // check if the new state will contain a hypothesis corresponding to the
-  // partial input
-  bool hasInput = checkNextStateHasInput(state, columnIndex, ngram);
-  if (findNewStateKey != columns_[columnIndex].statesIndexByStateKey_.end()) {
-    // first case: the new coverage and history already exist
-    Cost existingCost = findNewStateKey->second->cost();
-    State* oldState = findNewStateKey->second;
-    // if the new cost is smaller, then we need to remove the state from the
-    // set containing states sorted by cost then reinsert a new state so the
-    // ordering is still correct.
-    if (newCost < existingCost) {
-      newState = new State(oldState->stateId(), newStateKey, newCost,
-                           newFutureCost, hasInput || oldState->hasInput());
-      columns_[columnIndex].statesIndexByStateKey_[*newStateKey] = newState;
-      columns_[columnIndex].statesSortedByCost_.erase(oldState);
-      columns_[columnIndex].statesSortedByCost_.insert(newState);
-      delete oldState;
-    } else {
-      delete newStateKey;
-      newState = oldState;
-      if (hasInput) {
-        newState->setHasInput(hasInput);
-      }
-    }
-    // Now add states and arc for the n-gram
-    addFstStatesAndArcs(state, ngram, newState, arcWeight);
-  } else {
-    // second case: the new coverage and history don't already exist
-    // TODO refactor this bit
-    if (pruneNbest > 0 && columnIndex != inputWords_.size() &&
-        columns_[columnIndex].statesSortedByCost_.size() >= pruneNbest) {
-      std::set<State*, StatePointerComparator>::const_iterator stateIt =
-          columns_[columnIndex].statesSortedByCost_.end();
-      stateIt--;
-      Cost maxCost = (*stateIt)->cost();
-      if (newCost >= maxCost) {
-        return;
+void Lattice<Arc>::expandStates(
+    const std::vector<const State*>& states, const int begin, const int end,
+    const CandidateIndex& candidates, const int maxOverlap,
+    const bool allowDeletion, ExtensionBuffer* extensions,
+    LmCache* lmCache) const {
+  // the overlap is also bounded by the size of the history.
+  const int maxIndexOverlap =
+      std::max(0, std::min<int>(maxOverlap, languageModel_->Order() - 1));
+  const NgramTable& ngrams = candidates.ngrams();
+  CandidateIndex::Scratch scratch;
+  std::vector<const Candidate*> stateCandidates;
+  Ngram ngramToApply;
+  // the coverage of the n-gram applied, copied out of the table.
+  Coverage coverage;
+  for (int stateIndex = begin; stateIndex < end; ++stateIndex) {
+    const State& state = *states[stateIndex];
+    // the index only returns the candidates with a compatible overlap,
+    // history and start-of-sentence marker, in the order of the n-gram table.
+    candidates.find(state.coverage(), state.getKenlmState(),
+                    state.isInitial(), maxIndexOverlap, &scratch,
+                    &stateCandidates);
+    int appliedNgram = -1;
+    for (int c = 0; c < stateCandidates.size(); ++c) {
+      const Candidate& candidate = *stateCandidates[c];
+      // we use only the first coverage of the ngram to avoid spurious
+      // ambiguity (and therefore to have better pruning: e.g. if we keep 2
+      // states in a column and the first two correspond to the same
+      // hypothesis)
+      if (candidate.ngram == appliedNgram) {
+        continue;
       }
-      StateId nextStateId =
-          addFstStatesAndArcsNewState(state, ngram, arcWeight);
-      newState =
-          new State(nextStateId, newStateKey, newCost, newFutureCost, hasInput);
-      columns_[columnIndex].statesIndexByStateKey_[*newStateKey] = newState;
-      columns_[columnIndex].statesSortedByCost_.insert(newState);
-      stateIt = columns_[columnIndex].statesSortedByCost_.end();
-      stateIt--;
-      columns_[columnIndex].statesIndexByStateKey_.erase(
-          *((*stateIt)->stateKey()));
-      columns_[columnIndex].statesSortedByCost_.erase(stateIt);
-    }
-    else if (pruneThreshold > 0 && columnIndex != inputWords_.size() &&
-        !columns_[columnIndex].empty()) {
-      std::set<State*, StatePointerComparator>::const_iterator stateIt =
-          columns_[columnIndex].statesSortedByCost_.begin();
-      Cost minCost = (*stateIt)->cost();
-      Cost beam = minCost + pruneThreshold;
-      if (newCost > beam) {
-        return;
+      int offset;
+      if (canApply(state, ngrams, candidate.ngram, candidate.coverage,
+                   maxOverlap, &offset)) {
+        appliedNgram = candidate.ngram;
+        // the n-gram applied is truncated by the overlap.
+        const int* words = ngrams.words(candidate.ngram);
+        ngramToApply.assign(words + offset,
+                            words + ngrams.ngramSize(candidate.ngram));
+        ngrams.coverage(candidate.coverage, &coverage);
+        computeExtension(state, ngramToApply, ngrams, candidate.ngram, offset,
+                         coverage, lmCache, extensions->add());
+        if (allowDeletion && ngramToApply.size() == 1 &&
+            ngramToApply[0] !=STARTSENTENCE &&
+            ngramToApply[0] != ENDSENTENCE) {
+          computeDeletion(state, ngramToApply, ngrams, candidate.ngram,
+                          coverage, extensions->add());
+        }
       }
-      // TODO if newCost is the best cost, the beam changes and we need to
-      // remove states!!!
-    } else {
-      StateId nextStateId =
-          addFstStatesAndArcsNewState(state, ngram, arcWeight);
-      newState =
-          new State(nextStateId, newStateKey, newCost, newFutureCost, hasInput);
-      columns_[columnIndex].statesIndexByStateKey_[*newStateKey] = newState;
-      columns_[columnIndex].statesSortedByCost_.insert(newState);
     }
   }
 }
 
 template <class Arc>
-void Lattice<Arc>::extendDeletion(
-    const State& state, const Ngram& unigram, const Coverage& coverage,
-    const int pruneNbest, const float pruneThreshold) {
+void Lattice<Arc>::computeExtension(
+    const State& state, const Ngram& ngram, const NgramTable& ngrams,
+    const int ngramIndex, const int offset, const Coverage& coverage,
+    LmCache* lmCache, Extension* extension) const {
+  extension->state = &state;
+  extension->ngram = ngram;
+  extension->kenlmIndices = ngrams.kenlmIndices(ngramIndex) + offset;
+  // assignments rather than operator| so that the memory of the extension is
+  // reused.
+  extension->coverage = state.coverage();
+  extension->coverage |= coverage;
+  extension->deletion = false;
+  PrecomputedRule precomputed;
+  precomputed.kenlmIndices = extension->kenlmIndices;
+  precomputed.boundary = ngrams.lmBoundary(ngramIndex) - offset;
+  precomputed.interiorLmScore = ngrams.interiorLmScore(ngramIndex);
+  precomputed.endKenlmState = ngrams.endKenlmState(ngramIndex);
+  precomputed.featureCost = ngrams.cost(ngramIndex, offset);
+  precomputed.featureValues = ngrams.values(ngramIndex, offset);
+  // when no word applied depends on the history, the cost is precomputed and
+  // is not cached. This is the case for n-grams starting with a
+  // start-of-sentence marker and for n-grams at least as long as the order
+  // applied with an offset of order - 1, the longest overlap.
+  Cost ngramLmCost;
+  if (precomputed.boundary == 0) {
+    ngramLmCost = lmCost(state, ngram, precomputed, *languageModel_,
+                         &extension->kenlmState);
+  } else if (!lmCache->find(state.getKenlmState(), ngrams.id(ngramIndex),
+                            offset, &ngramLmCost, &extension->kenlmState)) {
+    ngramLmCost = lmCost(state, ngram, precomputed, *languageModel_,
+                         &extension->kenlmState);
+    lmCache->insert(state.getKenlmState(), ngrams.id(ngramIndex), offset,
+                    ngramLmCost, extension->kenlmState);
+  }
+  RuleCostAndWeightComputer<Arc> ruleCostAndWeightComputer;
+  Cost applyNgramCost = ruleCostAndWeightComputer.compute(
+      ngramLmCost, precomputed, *featureSet_, &extension->weight);
+  extension->futureCost = computeFutureCost(state, coverage);
+  extension->cost = state.cost() - state.futureCost() + applyNgramCost +
+      extension->futureCost;
+  extension->hash =
+      StateKey::hash(extension->coverage, extension->kenlmState);
+  // check if the new state will contain a hypothesis corresponding to the
+  // partial input
+  extension->hasInput =
+      checkNextStateHasInput(state, extension->coverage.count(), ngram);
+}
+
+template <class Arc>
+void Lattice<Arc>::computeDeletion(
+    const State& state, const Ngram& unigram, const NgramTable& ngrams,
+    const int ngramIndex, const Coverage& coverage,
+    Extension* extension) const {
   // check if we have a unigram, deletions are not allowed (for now at least)
   // for n-grams of size more than 1.
   CHECK_EQ(1, unigram.size()) << "Deletions are not allowed for n-grams other "
       "than unigrams";
-  Coverage newCoverage = state.coverage() | coverage;
-  int columnIndex = newCoverage.count();
-  lm::ngram::State* nextKenlmState = new lm::ngram::State();
-  Weight arcWeight;
+  extension->state = &state;
+  extension->ngram = unigram;
+  extension->kenlmIndices = NULL;
+  extension->coverage = state.coverage();
+  extension->coverage |= coverage;
+  extension->deletion = true;
   RuleCostAndWeightComputer<Arc> ruleCostAndWeightComputer;
   Cost applyNgramCost = ruleCostAndWeightComputer.computeDeletion(
-      state, unigram, weights_, featureNames_, nextKenlmState, &arcWeight);
-  Cost newFutureCost = computeFutureCost(newCoverage);
-  Cost newCost =
-      state.cost() - state.futureCost() + applyNgramCost + newFutureCost;
-  StateKey* newStateKey = new StateKey(newCoverage, *nextKenlmState);
-  delete nextKenlmState;
-  State* newState;
-  boost::unordered_map<StateKey, State*>::const_iterator findNewStateKey =
-      columns_[columnIndex].statesIndexByStateKey_.find(*newStateKey);
-  // check if the new state will contain a hypothesis corresponding to the
-  // partial input. Here we are deleting a unigram so the input is not there.
-  bool hasInput = false;
-  if (findNewStateKey != columns_[columnIndex].statesIndexByStateKey_.end()) {
+      state, unigram, ngrams.deletionCost(ngramIndex),
+      ngrams.deletionValues(ngramIndex), *featureSet_,
+      &extension->kenlmState, &extension->weight);
+  extension->futureCost = computeFutureCost(state, coverage);
+  extension->cost = state.cost() - state.futureCost() + applyNgramCost +
+      extension->futureCost;
+  extension->hash =
+      StateKey::hash(extension->coverage, extension->kenlmState);
+  // Here we are deleting a unigram so the input is not there.
+  extension->hasInput = false;
+}
+
+template <class Arc>
+void Lattice<Arc>::addExtension(const Extension& extension,
+                                const int pruneNbest,
+                                const float pruneThreshold) {
+  int columnIndex = extension.coverage.count();
+  Column& column = columns_[columnIndex];
+  Cost newCost = extension.cost;
+  bool hasInput = extension.hasInput;
+  int existing =
+      column.find(extension.coverage, extension.kenlmState, extension.hash);
+  if (existing >= 0) {
     // first case: the new coverage and history already exist
-    Cost existingCost = findNewStateKey->second->cost();
-    State* oldState = findNewStateKey->second;
-    // if the new cost is smaller, then we need to remove the state from the
-    // set containing states sorted by cost then reinsert a new state so the
-    // ordering is still correct.
-    if (newCost < existingCost) {
-      newState = new State(oldState->stateId(), newStateKey, newCost,
-                           newFutureCost, hasInput || oldState->hasInput());
-      columns_[columnIndex].statesIndexByStateKey_[*newStateKey] = newState;
-      columns_[columnIndex].statesSortedByCost_.erase(oldState);
-      columns_[columnIndex].statesSortedByCost_.insert(newState);
-      delete oldState;
+    State* existingState = column.state(existing);
+    if (newCost < existingState->cost()) {
+      column.updateCost(existing, newCost, extension.futureCost);
+    }
+    if (hasInput) {
+      existingState->setHasInput(hasInput);
+    }
+    // Now add states and arc for the n-gram
+    if (lazyFst_) {
+      addBackEdge(extension, existingState->stateId());
+    } else if (extension.deletion) {
+      addFstDeletion(*extension.state, existingState, extension.weight);
     } else {
-      delete newStateKey;
-      newState = oldState;
-      if (hasInput) {
-        newState->setHasInput(hasInput);
-      }
+      addFstStatesAndArcs(*extension.state, extension.ngram, existingState,
+                          extension.weight);
     }
-    // add deletion arc
-    addFstDeletion(state, newState, arcWeight);
-  } else {
-    // second case: the new coverage and history don't already exist
-    // TODO refactor this bit
-    if (pruneNbest > 0 && columnIndex != inputWords_.size() &&
-        columns_[columnIndex].statesSortedByCost_.size() >= pruneNbest) {
-      std::set<State*, StatePointerComparator>::const_iterator stateIt =
-          columns_[columnIndex].statesSortedByCost_.end();
-      stateIt--;
-      Cost maxCost = (*stateIt)->cost();
-      if (newCost >= maxCost) {
-        return;
+    return;
+  }
+  // second case: the new coverage and history don't already exist. The last
+  // column is never pruned.
+  if (columnIndex != inputWords_.size()) {
+    if (pruneNbest > 0) {
+      // states are pruned in batches: the column grows up to twice the n-best
+      // size before being pruned down to the n-best size.
+      if (column.size() >= 2 * pruneNbest) {
+        prune(&column, pruneNbest);
       }
-      StateId nextStateId = addFstDeletionNewState(state, arcWeight);
-      newState =
-          new State(nextStateId, newStateKey, newCost, newFutureCost, hasInput);
-      columns_[columnIndex].statesIndexByStateKey_[*newStateKey] = newState;
-      columns_[columnIndex].statesSortedByCost_.insert(newState);
-      stateIt = columns_[columnIndex].statesSortedByCost_.end();
-      stateIt--;
-      columns_[columnIndex].statesIndexByStateKey_.erase(
-          *((*stateIt)->stateKey()));
-      columns_[columnIndex].statesSortedByCost_.erase(stateIt);
-    }
-    else if (pruneThreshold > 0 && columnIndex != inputWords_.size() &&
-        !columns_[columnIndex].empty()) {
-      std::set<State*, StatePointerComparator>::const_iterator stateIt =
-          columns_[columnIndex].statesSortedByCost_.begin();
-      Cost minCost = (*stateIt)->cost();
-      Cost beam = minCost + pruneThreshold;
-      if (newCost > beam) {
+      // a state that is not better than the worst state kept by the last
+      // pruning cannot be in the n-best.
+      if (newCost >= column.pruneCost()) {
         return;
       }
-      // TODO if newCost is the best cost, the beam changes and we need to
-      // remove states!!!
-    } else {
-      StateId nextStateId = addFstDeletionNewState(state, arcWeight);
-      newState =
-          new State(nextStateId, newStateKey, newCost, newFutureCost, hasInput);
-      columns_[columnIndex].statesIndexByStateKey_[*newStateKey] = newState;
-      columns_[columnIndex].statesSortedByCost_.insert(newState);
+    }
+    if (pruneThreshold > 0 && !column.empty() &&
+        newCost > column.minCost() + pruneThreshold) {
+      return;
+    }
+  }
+  StateId nextStateId;
+  if (lazyFst_) {
+    nextStateId = addNode();
+    addBackEdge(extension, nextStateId);
+  } else {
+    nextStateId = addFstNewState(extension);
+  }
+  State* newState = new (states_.allocate()) State(
+      nextStateId, StateKey(extension.coverage, extension.kenlmState), newCost,
+      extension.futureCost, hasInput);
+  column.add(newState, extension.hash);
+}
+
+template <class Arc>
+void Lattice<Arc>::prune(Column* column, const int pruneNbest) {
+  prunedStates_.clear();
+  column->prune(pruneNbest, &prunedStates_);
+  for (int i = 0; i < prunedStates_.size(); ++i) {
+    states_.destroy(prunedStates_[i]);
+  }
+}
+
+template <class Arc>
+void Lattice<Arc>::releaseColumn(const int columnIndex) {
+  releasedColumnsHaveInput_[columnIndex] = columnHasInput(columnIndex);
+  prunedStates_.clear();
+  columns_[columnIndex].release(&prunedStates_);
+  for (int i = 0; i < prunedStates_.size(); ++i) {
+    if (prunedStates_[i] != initialState_) {
+      states_.destroy(prunedStates_[i]);
+    }
+  }
+}
+
+template <class Arc>
+bool Lattice<Arc>::columnHasInput(const int columnIndex) const {
+  if (releasedColumnsHaveInput_[columnIndex]) {
+    return true;
+  }
+  const Column& column = columns_[columnIndex];
+  for (int i = 0; i < column.size(); ++i) {
+    if (column.state(i)->hasInput()) {
+      return true;
     }
   }
+  return false;
+}
+
+template <class Arc>
+typename Lattice<Arc>::StateId Lattice<Arc>::addFstNewState(
+    const Extension& extension) {
+  if (extension.deletion) {
+    return addFstDeletionNewState(*extension.state, extension.weight);
+  }
+  return addFstStatesAndArcsNewState(*extension.state, extension.ngram,
+                                     extension.weight);
 }
 
 template <class Arc>
 void Lattice<Arc>::addFstStatesAndArcs(const State& state, const Ngram& ngram,
                                        const State* newState,
                                        const Weight& weight) {
-  StateId previousStateId = state.stateId();
-  StateId nextStateId;
-  for (int i = 0; i < ngram.size(); ++i) {
-    if (i == ngram.size() - 1) {
-      nextStateId = newState->stateId();
-      fst_->AddArc(
-          previousStateId, Arc(ngram[i], ngram[i], weight, nextStateId));
-    } else {
-      nextStateId = fst_->AddState();
-      fst_->AddArc(
-          previousStateId, Arc(ngram[i], ngram[i], Weight::One(), nextStateId));
-    }
-    previousStateId = nextStateId;
-  }
+  addFstArcs(state.stateId(), &ngram[0], ngram.size(), newState->stateId(),
+             weight);
 }
 
 template <class Arc>
 void Lattice<Arc>::addFstDeletion(const State& state, const State* newState,
                                   const Weight& weight) {
-  StateId previousStateId = state.stateId();
-  StateId nextStateId = newState->stateId();
-  // add an epsilon arc
-  fst_->AddArc(previousStateId, Arc(0, 0, weight, nextStateId));
+  addFstArcs(state.stateId(), NULL, 0, newState->stateId(), weight);
 }
 
 template <class Arc>
-typename Lattice<Arc>::StateId Lattice<Arc>::addFstStatesAndArcsNewState(
-    const State& state, const Ngram& ngram, const Weight& weight) {
-  StateId previousStateId = state.stateId();
-  StateId nextStateId;
-  for (int i = 0; i < ngram.size(); ++i) {
-    nextStateId = fst_->AddState();
-    if (i == ngram.size() - 1) {
-      fst_->AddArc(
-          previousStateId, Arc(ngram[i], ngram[i], weight, nextStateId));
-    } else {
-      fst_->AddArc(
-          previousStateId, Arc(ngram[i], ngram[i], Weight::One(), nextStateId));
+void Lattice<Arc>::addFstArcs(const StateId from, const int* words,
+                              const int numWords, const StateId to,
+                              const Weight& weight) {
+  if (numWords == 0) {
+    // add an epsilon arc
+    fst_->AddArc(from, Arc(0, 0, weight, to));
+    return;
+  }
+  StateId previousStateId = from;
+  for (int i = 0; i < numWords - 1; ++i) {
+    previousStateId = prefixState(previousStateId, words[i]);
+  }
+  fst_->AddArc(previousStateId,
+               Arc(words[numWords - 1], words[numWords - 1], weight, to));
+}
+
+template <class Arc>
+typename Lattice<Arc>::StateId Lattice<Arc>::prefixState(const StateId from,
+                                                         const int word) {
+  std::pair<typename boost::unordered_map<std::pair<StateId, int>,
+      StateId>::iterator, bool> inserted = prefixStates_.insert(
+          std::make_pair(std::make_pair(from, word), fst::kNoStateId));
+  if (inserted.second) {
+    inserted.first->second = fst_->AddState();
+    fst_->AddArc(from, Arc(word, word, Weight::One(), inserted.first->second));
+  }
+  return inserted.first->second;
+}
+
+template <class Arc>
+void Lattice<Arc>::addBackEdge(const Extension& extension,
+                               const StateId node) {
+  BackEdge edge;
+  edge.from = extension.state->stateId();
+  edge.wordsBegin = backEdgeWords_.size();
+  edge.numWords = extension.deletion ? 0 : extension.ngram.size();
+  edge.weight = extension.weight;
+  edge.previous = lastBackEdges_[node];
+  backEdgeWords_.insert(backEdgeWords_.end(), extension.ngram.begin(),
+                        extension.ngram.begin() + edge.numWords);
+  lastBackEdges_[node] = backEdges_.size();
+  backEdges_.push_back(edge);
+}
+
+template <class Arc>
+typename Lattice<Arc>::StateId Lattice<Arc>::addNode() {
+  lastBackEdges_.push_back(-1);
+  return lastBackEdges_.size() - 1;
+}
+
+template <class Arc>
+void Lattice<Arc>::buildFst(const Column& finalColumn) {
+  // fst state of each node, no state if the node does not reach the final
+  // column. Nodes are visited from the final column backwards so that only
+  // the hypotheses that survived get fst states and arcs.
+  std::vector<StateId> fstStates(lastBackEdges_.size(), fst::kNoStateId);
+  fstStates[initialState_->stateId()] = fst_->Start();
+  std::vector<StateId> toVisit;
+  for (int i = 0; i < finalColumn.size(); ++i) {
+    StateId node = finalColumn.state(i)->stateId();
+    if (fstStates[node] == fst::kNoStateId) {
+      fstStates[node] = fst_->AddState();
+      toVisit.push_back(node);
+    }
+    fst_->SetFinal(fstStates[node], Weight::One());
+  }
+  while (!toVisit.empty()) {
+    StateId node = toVisit.back();
+    toVisit.pop_back();
+    for (int e = lastBackEdges_[node]; e != -1; e = backEdges_[e].previous) {
+      const BackEdge& edge = backEdges_[e];
+      if (fstStates[edge.from] == fst::kNoStateId) {
+        fstStates[edge.from] = fst_->AddState();
+        toVisit.push_back(edge.from);
+      }
+      addFstArcs(fstStates[edge.from],
+                 edge.numWords == 0 ? NULL : &backEdgeWords_[edge.wordsBegin],
+                 edge.numWords, fstStates[node], edge.weight);
     }
-    previousStateId = nextStateId;
   }
+  prefixStates_.clear();
+  std::vector<BackEdge>().swap(backEdges_);
+  std::vector<int>().swap(backEdgeWords_);
+  std::vector<int>().swap(lastBackEdges_);
+}
+
+template <class Arc>
+typename Lattice<Arc>::StateId Lattice<Arc>::addFstStatesAndArcsNewState(
+    const State& state, const Ngram& ngram, const Weight& weight) {
+  StateId nextStateId = fst_->AddState();
+  addFstArcs(state.stateId(), &ngram[0], ngram.size(), nextStateId, weight);
   return nextStateId;
 }
 
@@ -759,27 +1207,19 @@ const bool Lattice<Arc>::checkNextStateHasInput(
 }
 
 template <class Arc>
-const Cost Lattice<Arc>::computeFutureCost(const Coverage& coverage) const {
-  Cost res = 0;
-  if (futureCostLanguageModel_) { // if NULL then no future cost estimated
-    lm::ngram::State startState(futureCostLanguageModel_->NullContextState()),
-        endState;
-    const lm::ngram::Vocabulary& vocab =
-        futureCostLanguageModel_->GetVocabulary();
-    const std::size_t sentenceSize = inputWords_.size();
-    for (std::size_t i = 0; i < sentenceSize; ++i) {
-      // if the bit at position sentenceSize - 1 - i is not set, this means that
-      // the word at position i has not been covered yet and the unigram LM is
-      // applied to that word
-      if (!coverage.test(sentenceSize - 1 - i) &&
-          inputWords_[i] != STARTSENTENCE &&
-          inputWords_[i] != ENDSENTENCE) {
-        res += futureCostLanguageModel_->Score(startState, index(vocab, inputWords_[i]), endState);
-        startState = endState;
-      }
-    }
+const Cost Lattice<Arc>::computeFutureCost(const State& state,
+                                           const Coverage& coverage) const {
+  if (positionFutureCosts_.empty()) {
+    return 0;
+  }
+  Coverage newlyCovered(coverage);
+  newlyCovered -= state.coverage();
+  Cost res = state.futureCost();
+  for (std::size_t bit = newlyCovered.findFirst(); bit != Coverage::npos;
+      bit = newlyCovered.findNext(bit)) {
+    res -= positionFutureCosts_[bit];
   }
-  return res * (-log(10));
+  return res;
 }
 
 } // namespace gen
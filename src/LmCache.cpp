@@ -0,0 +1,70 @@
+/*
+ * LmCache.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "LmCache.h"
+
+#include <boost/functional/hash.hpp>
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+LmCache::LmCache(const int size) : hits_(0), misses_(0) {
+  if (size > 0) {
+    std::size_t capacity = 1;
+    while (capacity < size) {
+      capacity <<= 1;
+    }
+    Entry empty;
+    empty.ngramId = -1;
+    entries_.resize(capacity, empty);
+  }
+}
+
+bool LmCache::find(const lm::ngram::State& kenlmState, const int ngramId,
+                   const int offset, Cost* cost,
+                   lm::ngram::State* nextKenlmState) {
+  if (entries_.empty()) {
+    return false;
+  }
+  const Entry& entry = entries_[slot(kenlmState, ngramId, offset)];
+  if (entry.ngramId == ngramId && entry.offset == offset &&
+      entry.kenlmState == kenlmState) {
+    ++hits_;
+    *cost = entry.cost;
+    *nextKenlmState = entry.nextKenlmState;
+    return true;
+  }
+  ++misses_;
+  return false;
+}
+
+void LmCache::insert(const lm::ngram::State& kenlmState, const int ngramId,
+                     const int offset, const Cost cost,
+                     const lm::ngram::State& nextKenlmState) {
+  if (entries_.empty()) {
+    return;
+  }
+  Entry& entry = entries_[slot(kenlmState, ngramId, offset)];
+  entry.ngramId = ngramId;
+  entry.offset = offset;
+  entry.kenlmState = kenlmState;
+  entry.cost = cost;
+  entry.nextKenlmState = nextKenlmState;
+}
+
+std::size_t LmCache::slot(const lm::ngram::State& kenlmState,
+                          const int ngramId, const int offset) const {
+  std::size_t seed = 0;
+  boost::hash_combine(seed, kenlmState);
+  boost::hash_combine(seed, ngramId);
+  boost::hash_combine(seed, offset);
+  return seed & (entries_.size() - 1);
+}
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
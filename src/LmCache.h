@@ -0,0 +1,116 @@
+/*
+ * LmCache.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef LMCACHE_H_
+#define LMCACHE_H_
+
+#include <vector>
+#include <lm/state.hh>
+
+#include "Types.h"
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+/**
+ * Bounded cache of language model transitions: the cost of applying a rule
+ * from a history and the resulting history. Many states of a column share the
+ * same history with different coverages and apply the same n-grams, so the
+ * same transitions are scored many times. The cache is direct mapped: each
+ * transition can only be stored in one slot and a new transition replaces the
+ * old one, which bounds the memory. The cache is not thread safe, there is one
+ * cache per thread.
+ */
+class LmCache {
+public:
+  /**
+   * Constructor.
+   * @param size The number of slots, rounded up to a power of two. If zero,
+   * nothing is cached.
+   */
+  explicit LmCache(const int size);
+
+  /**
+   * Looks up a transition.
+   * @param kenlmState The history the rule is applied from.
+   * @param ngramId The id of the n-gram the rule comes from.
+   * @param offset The number of words of the n-gram not applied because of
+   * an overlap.
+   * @param cost The cost of the transition, if found.
+   * @param nextKenlmState The history after the transition, if found.
+   * @return True if the transition was found.
+   */
+  bool find(const lm::ngram::State& kenlmState, const int ngramId,
+            const int offset, Cost* cost, lm::ngram::State* nextKenlmState);
+
+  /**
+   * Stores a transition.
+   * @param kenlmState The history the rule is applied from.
+   * @param ngramId The id of the n-gram the rule comes from.
+   * @param offset The number of words of the n-gram not applied because of
+   * an overlap.
+   * @param cost The cost of the transition.
+   * @param nextKenlmState The history after the transition.
+   */
+  void insert(const lm::ngram::State& kenlmState, const int ngramId,
+              const int offset, const Cost cost,
+              const lm::ngram::State& nextKenlmState);
+
+  /**
+   * Getter.
+   * @return The number of successful lookups.
+   */
+  long hits() const {
+    return hits_;
+  }
+
+  /**
+   * Getter.
+   * @return The number of failed lookups.
+   */
+  long misses() const {
+    return misses_;
+  }
+
+private:
+  /** A cached transition. */
+  struct Entry {
+    /** The n-gram id, minus one if the slot is empty. */
+    int ngramId;
+    /** The offset in the n-gram. */
+    int offset;
+    /** The history the rule is applied from. */
+    lm::ngram::State kenlmState;
+    /** The cost of the transition. */
+    Cost cost;
+    /** The history after the transition. */
+    lm::ngram::State nextKenlmState;
+  };
+
+  /**
+   * Computes the slot of a transition.
+   * @param kenlmState The history.
+   * @param ngramId The n-gram id.
+   * @param offset The offset.
+   * @return The slot index.
+   */
+  std::size_t slot(const lm::ngram::State& kenlmState, const int ngramId,
+                   const int offset) const;
+
+  /** The slots. */
+  std::vector<Entry> entries_;
+  /** Number of successful lookups. */
+  long hits_;
+  /** Number of failed lookups. */
+  long misses_;
+};
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
+
+#endif /* LMCACHE_H_ */
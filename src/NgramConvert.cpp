@@ -0,0 +1,85 @@
+/*
+ * NgramConvert.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "NgramFile.h"
+#include "Range.h"
+
+DEFINE_string(sentence_file, "",
+              "Name of a file containing the sentences to be reordered");
+DEFINE_string(ngrams, "", "Name of a directory containing ngram and coverage "
+              "files in text format (id.r.gz)");
+DEFINE_string(range, "1", "Range of items to be converted");
+DEFINE_string(output, "", "Directory where the n-gram files in binary format "
+              "(id.r.bin) are written. By default, the --ngrams directory, "
+              "where they are picked up by the decoder.");
+DEFINE_int32(inflate_threads, 1, "Number of threads used to decompress n-gram "
+             "files made of several gzip members.");
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+void checkArgs(int argc, char** argv) {
+  std::string usage = "Converts n-gram files to binary format.\n\n Usage: ";
+  usage += argv[0];
+  usage += " --sentence_file=sentenceFile --ngrams=ngramDirectory "
+      "--range=range [--output=outputDirectory]\n";
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  CHECK_NE("", FLAGS_sentence_file) << "Missing input sentence file "
+      "--sentence_file" << std::endl << usage;
+  CHECK_NE("", FLAGS_ngrams) << "Missing ngram directory --ngrams" <<
+      std::endl << usage;
+}
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
+
+/**
+ * Main function. Converts the n-gram files of several sentences.
+ */
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  using namespace cam::eng::gen;
+  checkArgs(argc, argv);
+  // only the sentence sizes are needed.
+  std::vector<int> sentenceSizes;
+  std::ifstream file(FLAGS_sentence_file.c_str());
+  CHECK(file.is_open()) << "Cannot open file " << FLAGS_sentence_file;
+  std::string line;
+  std::vector<std::string> words;
+  while (std::getline(file, line)) {
+    boost::split(words, line, boost::is_any_of(" "));
+    sentenceSizes.push_back(words.size());
+  }
+  const std::string& output =
+      FLAGS_output.empty() ? FLAGS_ngrams : FLAGS_output;
+  for (boost::scoped_ptr<IntegerRangeInterface> ir(
+      IntegerRangeInterface::initFactory(FLAGS_range)); !ir->done();
+      ir->next()) {
+    const int id = ir->get();
+    CHECK_GE(id, 1) << "Sentence ids start at 1";
+    CHECK_LE(id, sentenceSizes.size()) << "No sentence with id " << id;
+    std::ostringstream textFile;
+    textFile << FLAGS_ngrams << "/" << id << ".r.gz";
+    std::ostringstream binaryFile;
+    binaryFile << output << "/" << id << ".r.bin";
+    LOG(INFO) << "Converting " << textFile.str() << " to " <<
+        binaryFile.str();
+    convertNgramFile(textFile.str(), sentenceSizes[id - 1],
+                     FLAGS_inflate_threads, binaryFile.str());
+  }
+}
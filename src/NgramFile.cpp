@@ -0,0 +1,308 @@
+/*
+ * NgramFile.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "NgramFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <glog/logging.h>
+#include <zlib.h>
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+namespace {
+
+/** Magic at the beginning of an n-gram file in binary format. */
+const char kBinaryMagic[8] = { 'N', 'G', 'R', 'A', 'M', 'B', 'I', 'N' };
+
+/** Version of the binary format. */
+const boost::uint32_t kBinaryVersion = 1;
+
+/**
+ * Result of the decompression of a gzip member.
+ */
+struct GzipMember {
+  /** Whether the member was decompressed up to its end. */
+  bool ok;
+  /** Offset after the member in the compressed data. */
+  std::size_t end;
+  /** Decompressed data. */
+  std::string data;
+};
+
+/**
+ * Decompresses the gzip member starting at an offset.
+ * @param data The gzip data.
+ * @param size The size of the data.
+ * @param offset The offset of the member.
+ * @param member The result.
+ */
+void inflateMember(const char* data, const std::size_t size,
+                   const std::size_t offset, GzipMember* member) {
+  member->ok = false;
+  member->data.clear();
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  // 16 + MAX_WBITS: gzip header and trailer, one member at a time.
+  if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+    return;
+  }
+  // avail_in is 32 bits so the input is given in pieces.
+  const std::size_t maxPiece = 1 << 30;
+  std::size_t remaining = size - offset;
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(data + offset));
+  char out[1 << 16];
+  int ret = Z_OK;
+  while (ret == Z_OK) {
+    if (stream.avail_in == 0) {
+      if (remaining == 0) {
+        break;
+      }
+      stream.avail_in = std::min(remaining, maxPiece);
+      remaining -= stream.avail_in;
+    }
+    stream.next_out = reinterpret_cast<Bytef*>(out);
+    stream.avail_out = sizeof(out);
+    ret = inflate(&stream, Z_NO_FLUSH);
+    member->data.append(out, sizeof(out) - stream.avail_out);
+  }
+  if (ret == Z_STREAM_END) {
+    member->ok = true;
+    member->end = offset + stream.total_in;
+  }
+  inflateEnd(&stream);
+}
+
+/**
+ * Decompresses the gzip members starting at a slice of candidate offsets.
+ * @param data The gzip data.
+ * @param size The size of the data.
+ * @param starts The candidate offsets.
+ * @param begin The index of the first candidate of the slice.
+ * @param end The index after the last candidate of the slice.
+ * @param members The results, indexed like the candidates.
+ */
+void inflateMembers(const char* data, const std::size_t size,
+                    const std::vector<std::size_t>& starts, const int begin,
+                    const int end, std::vector<GzipMember>* members) {
+  for (int i = begin; i < end; ++i) {
+    inflateMember(data, size, starts[i], &(*members)[i]);
+  }
+}
+
+} // namespace
+
+NgramTextReader::NgramTextReader(const std::string& fileName,
+                                 const int numThreads) : fileName_(fileName) {
+  std::ifstream file(fileName.c_str(), std::ios::binary);
+  CHECK(file.is_open()) << "Cannot open file " << fileName;
+  file.seekg(0, std::ios::end);
+  std::vector<char> compressed(file.tellg());
+  file.seekg(0, std::ios::beg);
+  if (!compressed.empty()) {
+    file.read(&compressed[0], compressed.size());
+  }
+  CHECK(file) << "Cannot read file " << fileName;
+  CHECK(gunzip(compressed.empty() ? NULL : &compressed[0], compressed.size(),
+               numThreads, &buffer_)) << "Cannot decompress file " << fileName;
+  cursor_ = buffer_.data();
+  end_ = cursor_ + buffer_.size();
+  // skip the first two lines which are the ITG rules
+  skipLine();
+  skipLine();
+}
+
+bool NgramTextReader::next(std::vector<int>* positions, Ngram* ngram) {
+  while (cursor_ < end_ && *cursor_ == '\n') {
+    ++cursor_;
+  }
+  if (cursor_ == end_) {
+    return false;
+  }
+  line_ = cursor_;
+  // the first part is the nonterminal.
+  while (cursor_ < end_ && *cursor_ != ' ' && *cursor_ != '\n') {
+    ++cursor_;
+  }
+  CHECK(cursor_ < end_ && *cursor_ == ' ') << "Wrong format, should have at "
+      "least 3 parts: " << currentLine();
+  ++cursor_;
+  parseIntegers(positions);
+  CHECK(cursor_ < end_ && *cursor_ == ' ') << "Wrong format, should have at "
+      "least 3 parts: " << currentLine();
+  ++cursor_;
+  parseIntegers(ngram);
+  // the remaining parts are ignored.
+  skipLine();
+  return true;
+}
+
+void NgramTextReader::skipLine() {
+  cursor_ = std::find(cursor_, end_, '\n');
+  if (cursor_ < end_) {
+    ++cursor_;
+  }
+}
+
+std::string NgramTextReader::currentLine() const {
+  return std::string(line_, std::find(line_, end_, '\n'));
+}
+
+void NgramTextReader::parseIntegers(std::vector<int>* res) {
+  res->clear();
+  while (true) {
+    CHECK(cursor_ < end_ && *cursor_ >= '0' && *cursor_ <= '9') <<
+        "Wrong format, expected an integer in " << fileName_ << ": " <<
+        currentLine();
+    int value = 0;
+    for (; cursor_ < end_ && *cursor_ >= '0' && *cursor_ <= '9'; ++cursor_) {
+      value = value * 10 + (*cursor_ - '0');
+    }
+    res->push_back(value);
+    if (cursor_ == end_ || *cursor_ != '_') {
+      return;
+    }
+    ++cursor_;
+  }
+}
+
+NgramBinaryReader::NgramBinaryReader(const std::string& fileName) :
+    file_(fileName) {
+  CHECK(file_.is_open()) << "Cannot map file " << fileName;
+  CHECK_LE(sizeof(NgramBinaryHeader), file_.size()) << "Truncated n-gram "
+      "file " << fileName;
+  header_ = reinterpret_cast<const NgramBinaryHeader*>(file_.data());
+  CHECK(std::memcmp(header_->magic, kBinaryMagic, sizeof(kBinaryMagic)) == 0)
+      << "Not an n-gram file in binary format: " << fileName;
+  CHECK_EQ(kBinaryVersion, header_->version) << "Unsupported n-gram binary "
+      "format version in " << fileName;
+  const char* data = file_.data() + sizeof(NgramBinaryHeader);
+  coverages_ = reinterpret_cast<const Coverage::Block*>(data);
+  data += sizeof(Coverage::Block) * header_->numRecords * header_->numBlocks;
+  wordOffsets_ = reinterpret_cast<const boost::uint32_t*>(data);
+  data += sizeof(boost::uint32_t) * (header_->numRecords + 1);
+  words_ = reinterpret_cast<const boost::int32_t*>(data);
+  data += sizeof(boost::int32_t) * header_->numWords;
+  CHECK(data == file_.data() + file_.size()) << "Wrong size for n-gram file "
+      << fileName;
+}
+
+bool NgramBinaryReader::isBinary(const std::string& fileName) {
+  std::ifstream file(fileName.c_str(), std::ios::binary);
+  char magic[sizeof(kBinaryMagic)];
+  return file.read(magic, sizeof(magic)) &&
+      std::memcmp(magic, kBinaryMagic, sizeof(kBinaryMagic)) == 0;
+}
+
+bool gunzip(const char* data, const std::size_t size, const int numThreads,
+            std::string* res) {
+  res->clear();
+  if (numThreads <= 1) {
+    GzipMember member;
+    for (std::size_t offset = 0; offset < size; offset = member.end) {
+      inflateMember(data, size, offset, &member);
+      if (!member.ok) {
+        return false;
+      }
+      res->append(member.data);
+    }
+    return true;
+  }
+  // every member starts with a gzip header but a header may also appear in
+  // the compressed data of a member.
+  std::vector<std::size_t> starts;
+  for (std::size_t i = 0; i + 3 < size; ++i) {
+    if (static_cast<unsigned char>(data[i]) == 0x1f &&
+        static_cast<unsigned char>(data[i + 1]) == 0x8b &&
+        data[i + 2] == 8 && !(data[i + 3] & 0xe0)) {
+      starts.push_back(i);
+    }
+  }
+  if (starts.empty() || starts[0] != 0) {
+    return size == 0;
+  }
+  std::vector<GzipMember> members(starts.size());
+  int numSlices = std::min<int>(numThreads, starts.size());
+  boost::thread_group workers;
+  for (int i = 0; i < numSlices; ++i) {
+    workers.create_thread(boost::bind(
+        &inflateMembers, data, size, boost::cref(starts),
+        starts.size() * i / numSlices, starts.size() * (i + 1) / numSlices,
+        &members));
+  }
+  workers.join_all();
+  // follows the members from the beginning of the data. The candidates that
+  // are not reached are not members.
+  std::size_t i = 0;
+  while (true) {
+    if (!members[i].ok) {
+      return false;
+    }
+    res->append(members[i].data);
+    const std::size_t next = members[i].end;
+    if (next == size) {
+      return true;
+    }
+    i = std::lower_bound(starts.begin() + i + 1, starts.end(), next) -
+        starts.begin();
+    if (i == starts.size() || starts[i] != next) {
+      return false;
+    }
+  }
+}
+
+void convertNgramFile(const std::string& textFile, const int sentenceSize,
+                      const int numThreads, const std::string& binaryFile) {
+  NgramTextReader reader(textFile, numThreads);
+  std::vector<Coverage::Block> coverages;
+  std::vector<boost::uint32_t> wordOffsets(1, 0);
+  std::vector<boost::int32_t> words;
+  std::vector<int> positions;
+  Ngram ngram;
+  while (reader.next(&positions, &ngram)) {
+    Coverage coverage(sentenceSize);
+    for (int i = 0; i < positions.size(); ++i) {
+      CHECK_LT(positions[i], sentenceSize) << "Position out of the sentence "
+          "in " << textFile;
+      coverage.set(sentenceSize - 1 - positions[i]);
+    }
+    coverages.insert(coverages.end(), coverage.data(),
+                     coverage.data() + coverage.numBlocks());
+    words.insert(words.end(), ngram.begin(), ngram.end());
+    wordOffsets.push_back(words.size());
+  }
+  NgramBinaryHeader header;
+  std::memcpy(header.magic, kBinaryMagic, sizeof(kBinaryMagic));
+  header.version = kBinaryVersion;
+  header.sentenceSize = sentenceSize;
+  header.numBlocks = Coverage(sentenceSize).numBlocks();
+  header.numRecords = wordOffsets.size() - 1;
+  header.numWords = words.size();
+  std::ofstream file(binaryFile.c_str(), std::ios::binary);
+  CHECK(file.is_open()) << "Cannot open file " << binaryFile;
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (!coverages.empty()) {
+    file.write(reinterpret_cast<const char*>(&coverages[0]),
+               sizeof(Coverage::Block) * coverages.size());
+  }
+  file.write(reinterpret_cast<const char*>(&wordOffsets[0]),
+             sizeof(boost::uint32_t) * wordOffsets.size());
+  if (!words.empty()) {
+    file.write(reinterpret_cast<const char*>(&words[0]),
+               sizeof(boost::int32_t) * words.size());
+  }
+  CHECK(file) << "Cannot write file " << binaryFile;
+}
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
@@ -0,0 +1,200 @@
+/*
+ * NgramFile.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef NGRAMFILE_H_
+#define NGRAMFILE_H_
+
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "Types.h"
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+/**
+ * Reads a gzipped n-gram file in text format. The first two lines are ITG
+ * rules and are skipped. Each following line has the format
+ * X pos1_pos2_... word1_word2_...
+ * where the positions are the zero-based input positions covered by the
+ * n-gram. The whole file is decompressed into one buffer, which is then
+ * tokenized in place without any allocation per line. Files made of several
+ * gzip members (e.g. concatenated gzip files) are decompressed in parallel.
+ */
+class NgramTextReader {
+public:
+  /**
+   * Constructor. Reads and decompresses the file.
+   * @param fileName The file name.
+   * @param numThreads The number of threads used to decompress the gzip
+   * members of the file.
+   */
+  NgramTextReader(const std::string& fileName, const int numThreads);
+
+  /**
+   * Reads the next line.
+   * @param positions The positions covered by the n-gram.
+   * @param ngram The n-gram.
+   * @return False if the end of the file is reached.
+   */
+  bool next(std::vector<int>* positions, Ngram* ngram);
+
+private:
+  /**
+   * Skips the rest of the current line.
+   */
+  void skipLine();
+
+  /**
+   * Gets the current line, for error messages.
+   * @return The current line.
+   */
+  std::string currentLine() const;
+
+  /**
+   * Parses integers separated by underscores, up to a space or the end of
+   * the line.
+   * @param res The integers.
+   */
+  void parseIntegers(std::vector<int>* res);
+
+  /** Name of the file, for error messages. */
+  std::string fileName_;
+  /** Decompressed content of the file. */
+  std::string buffer_;
+  /** Beginning of the current line, for error messages. */
+  const char* line_;
+  /** Current position in the buffer. */
+  const char* cursor_;
+  /** End of the buffer. */
+  const char* end_;
+};
+
+/**
+ * Header of an n-gram file in binary format. The header is followed by:
+ * - the coverage blocks of each record, numBlocks blocks per record, in the
+ * layout of Coverage so that coverages are copied without any parsing,
+ * - numRecords + 1 offsets of the words of each record in the word pool,
+ * - the word pool.
+ * Records are in the order of the lines of the text file.
+ */
+struct NgramBinaryHeader {
+  /** Identifies the format. */
+  char magic[8];
+  /** Format version. */
+  boost::uint32_t version;
+  /** Number of words of the input sentence. */
+  boost::uint32_t sentenceSize;
+  /** Number of coverage blocks per record. */
+  boost::uint32_t numBlocks;
+  /** Number of records, i.e. of (coverage, n-gram) pairs. */
+  boost::uint32_t numRecords;
+  /** Number of words in the word pool. */
+  boost::uint64_t numWords;
+};
+
+/**
+ * Memory maps an n-gram file in binary format and gives access to its records
+ * in place.
+ */
+class NgramBinaryReader {
+public:
+  /**
+   * Constructor. Maps the file and checks its header.
+   * @param fileName The file name.
+   */
+  explicit NgramBinaryReader(const std::string& fileName);
+
+  /**
+   * Getter.
+   * @return The number of words of the input sentence.
+   */
+  int sentenceSize() const {
+    return header_->sentenceSize;
+  }
+
+  /**
+   * Getter.
+   * @return The number of records.
+   */
+  int numRecords() const {
+    return header_->numRecords;
+  }
+
+  /**
+   * Gets the coverage blocks of a record.
+   * @param record The record index.
+   * @return The blocks, in the layout of Coverage.
+   */
+  const Coverage::Block* coverage(const int record) const {
+    return coverages_ + record * header_->numBlocks;
+  }
+
+  /**
+   * Gets the words of a record.
+   * @param record The record index.
+   * @return The first word of the n-gram.
+   */
+  const boost::int32_t* wordsBegin(const int record) const {
+    return words_ + wordOffsets_[record];
+  }
+
+  /**
+   * Gets the end of the words of a record.
+   * @param record The record index.
+   * @return One past the last word of the n-gram.
+   */
+  const boost::int32_t* wordsEnd(const int record) const {
+    return words_ + wordOffsets_[record + 1];
+  }
+
+  /**
+   * Checks if a file is an n-gram file in binary format.
+   * @param fileName The file name.
+   * @return True if the file starts with the binary magic.
+   */
+  static bool isBinary(const std::string& fileName);
+
+private:
+  boost::iostreams::mapped_file_source file_;
+  const NgramBinaryHeader* header_;
+  const Coverage::Block* coverages_;
+  const boost::uint32_t* wordOffsets_;
+  const boost::int32_t* words_;
+};
+
+/**
+ * Decompresses gzip data made of one or more members. Members are found by
+ * their header and decompressed by several threads. Candidate headers that
+ * turn out to be inside the compressed data of a member are discarded, so
+ * the result does not depend on the number of threads.
+ * @param data The gzip data.
+ * @param size The size of the data.
+ * @param numThreads The number of threads.
+ * @param res The decompressed data.
+ * @return False if the data is not valid gzip data.
+ */
+bool gunzip(const char* data, const std::size_t size, const int numThreads,
+            std::string* res);
+
+/**
+ * Converts an n-gram file from text format to binary format.
+ * @param textFile The gzipped n-gram file in text format.
+ * @param sentenceSize The number of words of the input sentence.
+ * @param numThreads The number of threads used to decompress the text file.
+ * @param binaryFile The n-gram file in binary format to write.
+ */
+void convertNgramFile(const std::string& textFile, const int sentenceSize,
+                      const int numThreads, const std::string& binaryFile);
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
+
+#endif /* NGRAMFILE_H_ */
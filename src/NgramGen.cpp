@@ -70,6 +70,59 @@ DEFINE_bool(allow_deletion, false, "Allows unigrams to be deleted (an epsilon "
 DEFINE_string(future_cost_lm, "", "Directory containing unigram language "
     "models to estimate a future cost. The unigram language models are applied "
     "to the words not yet covered. By default, no future cost is estimated.");
+DEFINE_bool(future_cost_from_lm, false, "Estimates the future cost with the "
+    "unigram probabilities of the main language model, so that no separate "
+    "unigram language model is needed. Incompatible with --future_cost_lm.");
+DEFINE_bool(ngram_future_cost, false, "Estimates the future cost of each word "
+    "with the cheapest n-gram of the sentence that covers it: the language "
+    "model cost of the word within the n-gram plus its share of the n-gram "
+    "feature cost. This is a heuristic: the estimate is not a lower bound, "
+    "since a word may get a cheaper language model cost from a longer history "
+    "across n-gram boundaries and feature shares may be negative, so it is "
+    "not always tighter than the unigram estimate. Incompatible with "
+    "--future_cost_lm and --future_cost_from_lm.");
+DEFINE_int32(threads, 1, "Number of sentences decoded in parallel. Each thread "
+    "loads its own n-grams and language model for the sentence it decodes.");
+DEFINE_int32(extend_threads, 1, "Number of threads used to expand the states "
+    "of a column. Useful to reduce the latency of long sentences. The output "
+    "does not depend on the number of threads.");
+DEFINE_string(lm_cache, "", "Directory where language models in ARPA format "
+    "are cached in KenLM binary format. The first run converts each language "
+    "model, subsequent runs memory map the binary file. Cache entries are "
+    "keyed by language model path and modification time. By default, no "
+    "cache is used.");
+DEFINE_string(global_lm, "", "Language model file shared by all sentences, "
+    "preferably in KenLM binary format. If set, the language model is loaded "
+    "once and shared read-only by all lattices and threads instead of loading "
+    "one language model per sentence from --lm.");
+DEFINE_string(lm_load_method, "populate", "How binary language models are "
+    "loaded: 'lazy' (memory map, pages are read on demand), 'populate' (memory "
+    "map and prefault all pages) or 'read' (read into allocated memory).");
+DEFINE_int32(pipeline_queue_size, 0, "If greater than 0, loading n-grams and "
+    "language models, searching/compacting lattices and writing lattices are "
+    "done by different threads connected by queues of this size, so that the "
+    "next sentence is loaded while the current one is searched and the "
+    "previous one is written. --threads sets the number of search threads, "
+    "which also compact the lattices. By default, the stages are run one after "
+    "the other.");
+DEFINE_int32(lm_transition_cache_size, 65536, "Number of language model "
+    "transitions (history, n-gram) -> (cost, next history) cached by each "
+    "thread extending states, for each sentence. 0 disables the cache.");
+DEFINE_int32(inflate_threads, 1, "Number of threads used to decompress n-gram "
+    "files in text format. Only files made of several gzip members, e.g. "
+    "concatenated gzip files, are decompressed in parallel.");
+DEFINE_bool(lazy_ngram_loading, false, "Loads the n-grams of a chunk only when "
+    "the search reaches the chunk, so that only the n-grams of the current "
+    "chunk are in memory when the input is chopped. Needs n-gram files in "
+    "binary format (see NgramConvert). Incompatible with --ngram_future_cost.");
+DEFINE_bool(release_columns, false, "Releases the states of a column as soon as "
+    "the column is extended, so that the memory used by the states depends on "
+    "the number of columns not yet extended rather than on the input length. "
+    "The output is the same.");
+DEFINE_bool(lazy_fst, false, "Only records back edges between hypotheses "
+    "during search and builds the output fst from the hypotheses that reach "
+    "the last column, instead of adding fst states and arcs for every "
+    "hypothesis including the ones pruned later.");
 
 namespace cam {
 namespace eng {
@@ -85,8 +138,9 @@ void checkArgs(int argc, char** argv) {
   CHECK_NE("", FLAGS_sentence_file) << "Missing input --sentence_file" <<
       std::endl << usage;
   CHECK_NE("", FLAGS_ngrams) << "Missing ngrams --ngram" << std::endl << usage;
-  CHECK_NE("", FLAGS_lm) << "Missing language model directory --lm" <<
-      std::endl << usage;
+  CHECK(FLAGS_lm != "" || FLAGS_global_lm != "") << "Missing language model "
+      "directory --lm or global language model --global_lm" << std::endl <<
+      usage;
   CHECK_NE("", FLAGS_fstoutput) << "Missing output directory --fstoutput" <<
       std::endl << usage;
   CHECK((FLAGS_prune_nbest == 0 && FLAGS_prune_threshold == 0) ||
@@ -95,6 +149,24 @@ void checkArgs(int argc, char** argv) {
             "threshold strategy is allowed: --prune_nbest or --prune_threshold";
   CHECK(FLAGS_task == "decode" || FLAGS_task == "tune") << "Unknown task: " <<
       FLAGS_task << ". The task can only be 'decode' or 'tune'";
+  CHECK_LE(1, FLAGS_threads) << "The number of threads must be at least 1";
+  CHECK(FLAGS_future_cost_lm.empty() || !FLAGS_future_cost_from_lm) <<
+      "--future_cost_lm and --future_cost_from_lm are incompatible";
+  CHECK(!FLAGS_ngram_future_cost ||
+        (FLAGS_future_cost_lm.empty() && !FLAGS_future_cost_from_lm)) <<
+      "--ngram_future_cost is incompatible with --future_cost_lm and "
+      "--future_cost_from_lm";
+  CHECK(!FLAGS_lazy_ngram_loading || !FLAGS_ngram_future_cost) <<
+      "--lazy_ngram_loading is incompatible with --ngram_future_cost, which "
+      "needs the n-grams of all the chunks";
+  CHECK_LE(0, FLAGS_lm_transition_cache_size) << "The language model "
+      "transition cache size must be positive or zero";
+  CHECK_LE(0, FLAGS_pipeline_queue_size) << "The pipeline queue size must be "
+      "positive";
+  CHECK_LE(1, FLAGS_extend_threads) << "The number of extend threads must be "
+      "at least 1";
+  CHECK_LE(1, FLAGS_inflate_threads) << "The number of inflate threads must "
+      "be at least 1";
   // TODO check all flags
   // TODO check for length dependent pruning
 }
@@ -117,6 +189,11 @@ int main(int argc, char** argv) {
       FLAGS_dump_prune, FLAGS_add_input, FLAGS_when_lost_input, FLAGS_features,
       FLAGS_weights, FLAGS_task, FLAGS_chop, FLAGS_max_chop, FLAGS_punctuation,
       FLAGS_wordmap, FLAGS_chop_file, FLAGS_constraints,
-      FLAGS_constraints_file, FLAGS_allow_deletion, FLAGS_future_cost_lm);
+      FLAGS_constraints_file, FLAGS_allow_deletion, FLAGS_future_cost_lm,
+      FLAGS_threads, FLAGS_extend_threads, FLAGS_lm_cache, FLAGS_global_lm,
+      FLAGS_lm_load_method, FLAGS_pipeline_queue_size,
+      FLAGS_lm_transition_cache_size, FLAGS_future_cost_from_lm,
+      FLAGS_ngram_future_cost, FLAGS_inflate_threads,
+      FLAGS_lazy_ngram_loading, FLAGS_release_columns, FLAGS_lazy_fst);
   decoder.decode();
 }
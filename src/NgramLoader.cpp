@@ -7,109 +7,208 @@
 
 #include "NgramLoader.h"
 
-#include <fstream>
-#include <boost/algorithm/string.hpp>
-#include <boost/lexical_cast.hpp>
-#include <boost/iostreams/filtering_stream.hpp>
-#include <boost/iostreams/filter/gzip.hpp>
+#include <sstream>
 #include <glog/logging.h>
 
+#include "NgramFile.h"
 #include "Util.h"
 
 namespace cam {
 namespace eng {
 namespace gen {
 
-NgramLoader::NgramLoader(const std::vector<int>& inputSentence) :
-    inputSentence_(inputSentence) {}
+NgramLoader::NgramLoader(const std::vector<int>& inputSentence,
+                         boost::shared_ptr<LanguageModel> languageModel,
+                         boost::shared_ptr<FeatureSet> featureSet,
+                         const bool storeFeatureValues) :
+    inputSentence_(inputSentence), languageModel_(languageModel),
+    featureSet_(featureSet), storeFeatureValues_(storeFeatureValues),
+    numNgrams_(0) {}
 
 void NgramLoader::loadNgram(const std::string& fileName,
                             const std::vector<int>& splitPositions,
-                            const std::vector<bool>& chunksToReorder) {
+                            const std::vector<bool>& chunksToReorder,
+                            const int inflateThreads, const bool lazy) {
   // ngrams_ has a size which is the number of chunks, splitPositions as well.
   // even with one chunk, splitPositions contains one element which is the
-  // input sentence size.
+  // input sentence size. The coverages are first grouped by n-gram in sorted
+  // maps, which are then flattened into tables.
+  splitPositions_ = splitPositions;
+  chunksToReorder_ = chunksToReorder;
   ngrams_.resize(splitPositions.size());
-  std::ifstream file(fileName.c_str());
-  boost::iostreams::filtering_istream istream;
-  istream.push(boost::iostreams::gzip_decompressor());
-  istream.push(file);
-  CHECK(file.is_open()) << "Cannot open file " << fileName;
-  std::string line;
-  // skip the first two lines which are the ITG rules
-  std::getline(istream, line);
-  std::getline(istream, line);
-  std::vector<std::string> parts;
-  std::vector<std::string> ngramString;
-  Ngram ngramInt;
-  while (std::getline(istream, line)) {
-    boost::split(parts, line, boost::is_any_of(" "));
-    CHECK_LE(3, parts.size()) << "Wrong format, should have at least 3 parts: "
-        << line;
+  candidateIndices_.resize(splitPositions.size());
+  loadedChunks_.assign(splitPositions.size(), false);
+  const bool binary = NgramBinaryReader::isBinary(fileName);
+  if (lazy && binary) {
+    // the records are only indexed by chunk. The file stays mapped so that
+    // the records of a chunk are read when the chunk is loaded.
+    reader_.reset(new NgramBinaryReader(fileName));
+    CHECK_EQ(inputSentence_.size(), reader_->sentenceSize()) << "The n-gram "
+        "file " << fileName << " does not correspond to the input sentence";
+    chunkRecords_.assign(splitPositions.size(), std::vector<int>());
     Coverage coverage;
-    positionList2Coverage(parts[1], &coverage);
-    // chunkId is the chunk id where the coverage should belong. For example, if
-    // there is no split, then all coverages belong to chunkId zero. For an
-    // input "a b c d" and split positions <2>, then a coverage 1100 belongs to
-    // chunkId zero, a coverage 0011 belongs to chunkId one, and a coverage 0110
-    // belongs nowhere (by convention, chunkId minus one).
-    int chunkId = getChunkId(coverage, splitPositions);
-    // if chunkId is negative (meaning the n-gram doesn't belong to any
-    // specific chunk) or if the chunk is not supposed to be reordered, then we
-    // don't load any n-gram for that chunk
-    if (chunkId < 0 ||
-        (chunkId < chunksToReorder.size() && !chunksToReorder[chunkId])) {
-      continue;
-    }
-    boost::split(ngramString, parts[2], boost::is_any_of("_"));
-    ngramInt.resize(ngramString.size());
-    std::transform(ngramString.begin(), ngramString.end(), ngramInt.begin(),
-                   boost::lexical_cast<int, std::string>);
-    ngrams_[chunkId][ngramInt].push_back(coverage);
-  }
-  // for chunks that are not supposed to be reordered, load the input chunk as
-  // unique n-gram for that chunk.
-  for (int chunkId = 0; chunkId < chunksToReorder.size(); ++chunkId) {
-    if (!chunksToReorder[chunkId]) {
-      std::stringstream bits;
-      for (int i = 0; i < (chunkId > 0 ? splitPositions[chunkId - 1] : 0);
-          ++i) {
-        bits << "0";
-      }
-      for (int i = (chunkId > 0 ? splitPositions[chunkId - 1] : 0);
-          i < splitPositions[chunkId]; ++i) {
-        bits << "1";
-      }
-      for (int i = splitPositions[chunkId]; i < inputSentence_.size(); ++i) {
-        bits << "0";
-      }
-      Coverage chunkCoverage(bits.str());
-      std::vector<int> chunk;
-      for (int i = (chunkId > 0 ? splitPositions[chunkId - 1] : 0);
-          i < splitPositions[chunkId]; ++i) {
-        chunk.push_back(inputSentence_[i]);
+    for (int record = 0; record < reader_->numRecords(); ++record) {
+      coverage.assign(reader_->coverage(record), inputSentence_.size());
+      int chunkId = getChunkToLoad(coverage);
+      if (chunkId >= 0) {
+        chunkRecords_[chunkId].push_back(record);
       }
-      ngrams_[chunkId].clear();
-      ngrams_[chunkId][chunk].push_back(chunkCoverage);
     }
+    return;
+  }
+  if (lazy) {
+    LOG(WARNING) << "Lazy loading needs n-grams in binary format, loading all "
+        "the chunks of " << fileName << " at once";
+  }
+  std::vector<CoverageMap> coverageMaps(splitPositions.size());
+  if (binary) {
+    // coverages are stored in place in the binary file so they are copied
+    // without any parsing.
+    NgramBinaryReader reader(fileName);
+    CHECK_EQ(inputSentence_.size(), reader.sentenceSize()) << "The n-gram "
+        "file " << fileName << " does not correspond to the input sentence";
+    Coverage coverage;
+    Ngram ngram;
+    for (int record = 0; record < reader.numRecords(); ++record) {
+      coverage.assign(reader.coverage(record), inputSentence_.size());
+      ngram.assign(reader.wordsBegin(record), reader.wordsEnd(record));
+      addCoverage(ngram, coverage, &coverageMaps);
+    }
+  } else {
+    NgramTextReader reader(fileName, inflateThreads);
+    std::vector<int> positions;
+    Ngram ngram;
+    while (reader.next(&positions, &ngram)) {
+      Coverage coverage;
+      positionList2Coverage(positions, &coverage);
+      addCoverage(ngram, coverage, &coverageMaps);
+    }
+  }
+  for (int chunkId = 0; chunkId < ngrams_.size(); ++chunkId) {
+    addMonotoneChunk(chunkId, &coverageMaps[chunkId]);
+    buildChunk(chunkId, &coverageMaps[chunkId]);
   }
 }
 
-const std::map<Ngram, std::vector<Coverage> >& NgramLoader::ngrams(
-    const int chunkId) const {
+void NgramLoader::loadChunk(const int chunkId) {
   CHECK_LT(chunkId, ngrams_.size()) << "Invalid chunk id " << chunkId << ". "
       "Must be less than the size of the number of chunks: " << ngrams_.size();
+  if (loadedChunks_[chunkId]) {
+    return;
+  }
+  CHECK(reader_) << "The n-grams of chunk " << chunkId << " were released "
+      "and cannot be loaded again without lazy loading";
+  CoverageMap coverageMap;
+  Coverage coverage;
+  Ngram ngram;
+  const std::vector<int>& records = chunkRecords_[chunkId];
+  for (int i = 0; i < records.size(); ++i) {
+    coverage.assign(reader_->coverage(records[i]), inputSentence_.size());
+    ngram.assign(reader_->wordsBegin(records[i]),
+                 reader_->wordsEnd(records[i]));
+    coverageMap[ngram].push_back(coverage);
+  }
+  addMonotoneChunk(chunkId, &coverageMap);
+  buildChunk(chunkId, &coverageMap);
+}
+
+void NgramLoader::releaseChunk(const int chunkId) {
+  CHECK_LT(chunkId, ngrams_.size()) << "Invalid chunk id " << chunkId << ". "
+      "Must be less than the size of the number of chunks: " << ngrams_.size();
+  NgramTable().swap(ngrams_[chunkId]);
+  CandidateIndex().swap(candidateIndices_[chunkId]);
+  loadedChunks_[chunkId] = false;
+}
+
+const NgramTable& NgramLoader::ngrams(const int chunkId) const {
+  CHECK_LT(chunkId, ngrams_.size()) << "Invalid chunk id " << chunkId << ". "
+      "Must be less than the size of the number of chunks: " << ngrams_.size();
+  CHECK(loadedChunks_[chunkId]) << "The n-grams of chunk " << chunkId <<
+      " are not loaded";
   return ngrams_[chunkId];
 }
 
-void NgramLoader::positionList2Coverage(const std::string& positionList,
+const CandidateIndex& NgramLoader::candidates(const int chunkId) const {
+  CHECK_LT(chunkId, candidateIndices_.size()) << "Invalid chunk id " <<
+      chunkId << ". Must be less than the size of the number of chunks: " <<
+      candidateIndices_.size();
+  CHECK(loadedChunks_[chunkId]) << "The n-grams of chunk " << chunkId <<
+      " are not loaded";
+  return candidateIndices_[chunkId];
+}
+
+void NgramLoader::buildTable(const CoverageMap& coverageMap,
+                             NgramTable* table) {
+  table->clear(numNgrams_, featureSet_->size(), storeFeatureValues_);
+  std::vector<lm::WordIndex> kenlmIndices;
+  NgramCosts costs;
+  for (CoverageMap::const_iterator it = coverageMap.begin();
+      it != coverageMap.end(); ++it) {
+    const Ngram& ngram = it->first;
+    languageModel_->indices(ngram, &kenlmIndices);
+    computeCosts(ngram, &costs);
+    computeInteriorLmScore(ngram, kenlmIndices, &costs);
+    table->add(ngram, kenlmIndices, it->second, costs);
+  }
+  numNgrams_ += table->size();
+}
+
+void NgramLoader::computeCosts(const Ngram& ngram, NgramCosts* entry) const {
+  const int numFeatures = featureSet_->size();
+  const bool storeValues = storeFeatureValues_ && numFeatures > 0;
+  entry->costs.resize(ngram.size());
+  if (storeValues) {
+    entry->featureValues.resize(ngram.size() * numFeatures);
+    entry->deletionFeatureValues.resize(numFeatures);
+  }
+  Ngram rule;
+  for (int offset = 0; offset < ngram.size(); ++offset) {
+    rule.assign(ngram.begin() + offset, ngram.end());
+    entry->costs[offset] = featureSet_->cost(
+        rule, storeValues ? &entry->featureValues[offset * numFeatures] : NULL);
+  }
+  rule.assign(ngram.end() - 1, ngram.end());
+  entry->deletionCost = featureSet_->deletionCost(
+      rule, storeValues ? &entry->deletionFeatureValues[0] : NULL);
+}
+
+void NgramLoader::computeInteriorLmScore(
+    const Ngram& ngram, const std::vector<lm::WordIndex>& kenlmIndices,
+    NgramCosts* entry) const {
+  const int order = languageModel_->Order();
+  lm::ngram::State state;
+  int begin;
+  if (ngram[0] == STARTSENTENCE) {
+    entry->lmBoundary = 0;
+    state = languageModel_->BeginSentenceState();
+    begin = 1;
+  } else if (ngram.size() >= order) {
+    // after order - 1 words, the KenLM state no longer depends on the
+    // history before the n-gram.
+    entry->lmBoundary = order - 1;
+    state = languageModel_->NullContextState();
+    begin = 0;
+  } else {
+    entry->lmBoundary = ngram.size();
+    entry->interiorLmScore = 0;
+    return;
+  }
+  entry->interiorLmScore = 0;
+  lm::ngram::State nextState;
+  for (int i = begin; i < ngram.size(); ++i) {
+    float score =
+        languageModel_->Score(state, kenlmIndices[i], nextState);
+    if (i >= entry->lmBoundary) {
+      entry->interiorLmScore += score;
+    }
+    state = nextState;
+  }
+  entry->endKenlmState = state;
+}
+
+void NgramLoader::positionList2Coverage(const std::vector<int>& positions,
                                         Coverage* coverage) {
   coverage->resize(inputSentence_.size());
-  std::vector<std::string> stringPositions;
-  boost::split(stringPositions, positionList, boost::is_any_of("_"));
-  std::vector<int> positions(stringPositions.size());
-  std::transform(stringPositions.begin(), stringPositions.end(),
-                 positions.begin(), boost::lexical_cast<int, std::string>);
   // here we emulate the behaviour of the boost::dynamic_bitset constructor
   // from a string that fills backwards.
   for (int i = 0; i < positions.size(); ++i) {
@@ -117,6 +216,62 @@ void NgramLoader::positionList2Coverage(const std::string& positionList,
   }
 }
 
+int NgramLoader::getChunkToLoad(const Coverage& coverage) {
+  // chunkId is the chunk id where the coverage should belong. For example, if
+  // there is no split, then all coverages belong to chunkId zero. For an
+  // input "a b c d" and split positions <2>, then a coverage 1100 belongs to
+  // chunkId zero, a coverage 0011 belongs to chunkId one, and a coverage 0110
+  // belongs nowhere (by convention, chunkId minus one).
+  int chunkId = getChunkId(coverage, splitPositions_);
+  // if chunkId is negative (meaning the n-gram doesn't belong to any
+  // specific chunk) or if the chunk is not supposed to be reordered, then we
+  // don't load any n-gram for that chunk
+  if (chunkId < 0 ||
+      (chunkId < chunksToReorder_.size() && !chunksToReorder_[chunkId])) {
+    return -1;
+  }
+  return chunkId;
+}
+
+void NgramLoader::addCoverage(const Ngram& ngram, const Coverage& coverage,
+                              std::vector<CoverageMap>* coverageMaps) {
+  int chunkId = getChunkToLoad(coverage);
+  if (chunkId >= 0) {
+    (*coverageMaps)[chunkId][ngram].push_back(coverage);
+  }
+}
+
+void NgramLoader::addMonotoneChunk(const int chunkId,
+                                   CoverageMap* coverageMap) {
+  if (chunkId >= chunksToReorder_.size() || chunksToReorder_[chunkId]) {
+    return;
+  }
+  const int begin = chunkId > 0 ? splitPositions_[chunkId - 1] : 0;
+  const int end = splitPositions_[chunkId];
+  std::stringstream bits;
+  for (int i = 0; i < begin; ++i) {
+    bits << "0";
+  }
+  for (int i = begin; i < end; ++i) {
+    bits << "1";
+  }
+  for (int i = end; i < inputSentence_.size(); ++i) {
+    bits << "0";
+  }
+  Coverage chunkCoverage(bits.str());
+  std::vector<int> chunk(inputSentence_.begin() + begin,
+                         inputSentence_.begin() + end);
+  (*coverageMap)[chunk].push_back(chunkCoverage);
+}
+
+void NgramLoader::buildChunk(const int chunkId, CoverageMap* coverageMap) {
+  buildTable(*coverageMap, &ngrams_[chunkId]);
+  // the map is released as soon as it is flattened.
+  CoverageMap().swap(*coverageMap);
+  candidateIndices_[chunkId].build(ngrams_[chunkId], inputSentence_.size());
+  loadedChunks_[chunkId] = true;
+}
+
 int NgramLoader::getChunkId(const Coverage& coverage,
                             const std::vector<int>& splitPositions) {
   // if there is no split, then all coverages belong to chunkId zero.
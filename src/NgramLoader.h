@@ -10,7 +10,13 @@
 
 #include <map>
 #include <vector>
+#include <boost/smart_ptr.hpp>
 
+#include "CandidateIndex.h"
+#include "features/FeatureSet.h"
+#include "LanguageModel.h"
+#include "NgramFile.h"
+#include "NgramTable.h"
 #include "Types.h"
 
 namespace cam {
@@ -32,38 +38,121 @@ public:
   /**
    * Constructor.
    * @param inputSentence The input sentence to be reordered.
+   * @param languageModel The language model used to translate the n-gram
+   * words to KenLM indices.
+   * @param featureSet The features used to compute the n-gram costs.
+   * @param storeFeatureValues Whether to store the feature values as well as
+   * the weighted costs (needed in tuning).
    */
-  NgramLoader(const std::vector<int>& inputSentence);
+  NgramLoader(const std::vector<int>& inputSentence,
+              boost::shared_ptr<LanguageModel> languageModel,
+              boost::shared_ptr<FeatureSet> featureSet,
+              const bool storeFeatureValues);
 
   /**
-   * Reads a file containing n-grams and coverages and loads them.
+   * Reads a file containing n-grams and coverages and loads them. The file is
+   * either in gzipped text format or in binary format (see NgramFile.h), which
+   * is detected from its content.
    * @param fileName The file name.
    * @param splitPositions The zero-based positions in the input that indicate
    * where to split it. Position p means that a new chunk must start at position
    * p. N-grams with coverage relevant to a specific chunk will be loaded for
    * that chunk.
+   * @param chunksToReorder Which chunks are reordered.
+   * @param inflateThreads The number of threads used to decompress a text
+   * file.
+   * @param lazy Whether the n-grams of a chunk are only loaded when the chunk
+   * is needed (see loadChunk). Only the records of a binary file are indexed
+   * by chunk at this point; a text file is always loaded at once.
    */
   void loadNgram(
       const std::string& fileName, const std::vector<int>& splitPositions,
-      const std::vector<bool>& chunksToReorder);
+      const std::vector<bool>& chunksToReorder, const int inflateThreads,
+      const bool lazy);
+
+  /**
+   * Loads the n-grams of a chunk if they are not loaded yet. Only needed with
+   * lazy loading or after the chunk was released.
+   * @param chunkId The zero-based chunk id.
+   */
+  void loadChunk(const int chunkId);
+
+  /**
+   * Releases the memory of the n-grams of a chunk once the chunk is no longer
+   * needed. Without lazy loading, the chunk cannot be loaded again.
+   * @param chunkId The zero-based chunk id.
+   */
+  void releaseChunk(const int chunkId);
 
   /**
    * Gets the n-grams for a specific zero-based chunk id.
    * @param chunkId The zero-based chunk id.
    * @return The n-grams for a specific zero-based chunk id.
    */
-  const std::map<Ngram, std::vector<Coverage> >& ngrams(
-      const int chunkId) const;
+  const NgramTable& ngrams(const int chunkId) const;
+
+  /**
+   * Gets the index over the n-grams of a chunk used to find the n-grams that
+   * may extend a state.
+   * @param chunkId The zero-based chunk id.
+   * @return The index for the chunk.
+   */
+  const CandidateIndex& candidates(const int chunkId) const;
+
+  /**
+   * Getter.
+   * @return The number of chunks.
+   */
+  int numChunks() const {
+    return ngrams_.size();
+  }
 
 private:
+  /** Coverages of each n-gram of a chunk, sorted by n-gram. */
+  typedef std::map<Ngram, std::vector<Coverage> > CoverageMap;
+
   /**
    * Converts a position list to a coverage bitstring.
-   * @param positionList The position list. The format is pos1_pos2 etc.
+   * @param positions The zero-based positions.
    * @param coverage The resulting coverage bitstring.
    */
-  void positionList2Coverage(const std::string& positionList,
+  void positionList2Coverage(const std::vector<int>& positions,
                              Coverage* coverage);
 
+  /**
+   * Gets the chunk whose n-grams a coverage read from a file is loaded for.
+   * @param coverage The coverage.
+   * @return The chunk id, minus one if the coverage overlaps multiple chunks
+   * or if its chunk is not reordered.
+   */
+  int getChunkToLoad(const Coverage& coverage);
+
+  /**
+   * Adds a coverage of an n-gram read from a file to the chunk the coverage
+   * belongs to, if any.
+   * @param ngram The n-gram.
+   * @param coverage The coverage.
+   * @param coverageMaps The coverages of each chunk.
+   */
+  void addCoverage(const Ngram& ngram, const Coverage& coverage,
+                   std::vector<CoverageMap>* coverageMaps);
+
+  /**
+   * For a chunk that is not reordered, adds the input chunk as unique n-gram
+   * for that chunk.
+   * @param chunkId The chunk id.
+   * @param coverageMap The coverages of the chunk.
+   */
+  void addMonotoneChunk(const int chunkId, CoverageMap* coverageMap);
+
+  /**
+   * Builds the table and the candidate index of a chunk. The map is released
+   * as soon as it is flattened.
+   * @param chunkId The chunk id.
+   * @param coverageMap The coverages of each n-gram of the chunk.
+   */
+  void buildChunk(const int chunkId, CoverageMap* coverageMap);
+
   /**
    * Gets the chunk id where the coverage should belong. For example, if there
    * is no split, then all coverages belong to chunkId zero. For an input
@@ -80,15 +169,74 @@ private:
                  const std::vector<int>& splitPositions);
 
   /**
-   * List of maps between an n-gram (sequence of words) and coverages.
-   * There may be multiple coverages if a word in the input is repeated.
+   * Flattens the n-grams of a chunk into a table. The KenLM indices and the
+   * costs are computed for each n-gram.
+   * @param coverageMap The coverages of each n-gram of the chunk.
+   * @param table The resulting table.
+   */
+  void buildTable(const CoverageMap& coverageMap, NgramTable* table);
+
+  /**
+   * Computes the feature costs of an n-gram for each offset.
+   * @param ngram The n-gram.
+   * @param entry The costs.
+   */
+  void computeCosts(const Ngram& ngram, NgramCosts* entry) const;
+
+  /**
+   * Computes the language model score of the words of an n-gram that does not
+   * depend on the history the n-gram is applied from. These are the words
+   * from position order - 1 on since their history is within the n-gram, or
+   * all the words if the n-gram starts with a start-of-sentence marker.
+   * @param ngram The n-gram.
+   * @param kenlmIndices The KenLM indices of the words of the n-gram.
+   * @param entry The costs receiving the score.
+   */
+  void computeInteriorLmScore(const Ngram& ngram,
+                              const std::vector<lm::WordIndex>& kenlmIndices,
+                              NgramCosts* entry) const;
+
+  /**
+   * List of tables of n-grams and coverages.
    * The list may have more than one element if the input is chopped.
    */
-  std::vector<std::map<Ngram, std::vector<Coverage> > > ngrams_;
+  std::vector<NgramTable> ngrams_;
+
+  /** Candidate index of each chunk, built once the n-grams are loaded. */
+  std::vector<CandidateIndex> candidateIndices_;
+
+  /** Whether the n-grams of each chunk are loaded. */
+  std::vector<bool> loadedChunks_;
+
+  /** Where to split the input into chunks. */
+  std::vector<int> splitPositions_;
+
+  /** Which chunks are reordered. */
+  std::vector<bool> chunksToReorder_;
+
+  /** With lazy loading, the binary n-gram file, kept mapped until the
+   * loader is destroyed. */
+  boost::shared_ptr<NgramBinaryReader> reader_;
+
+  /** With lazy loading, the records of the binary file loaded for each
+   * chunk. */
+  std::vector<std::vector<int> > chunkRecords_;
 
   /** Input sentence to be reordered. */
   std::vector<int> inputSentence_;
 
+  /** Language model used to compute the KenLM indices. */
+  boost::shared_ptr<LanguageModel> languageModel_;
+
+  /** Features used to compute the n-gram costs. */
+  boost::shared_ptr<FeatureSet> featureSet_;
+
+  /** Whether feature values are stored as well as weighted costs. */
+  bool storeFeatureValues_;
+
+  /** Number of distinct n-grams loaded, used to assign n-gram ids. */
+  int numNgrams_;
+
 };
 
 } // namespace gen
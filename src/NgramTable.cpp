@@ -0,0 +1,108 @@
+/*
+ * NgramTable.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "NgramTable.h"
+
+#include <algorithm>
+
+#include "Util.h"
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+NgramTable::NgramTable() {
+  clear(0, 0, false);
+}
+
+void NgramTable::clear(const int firstId, const int numFeatures,
+                       const bool storeValues) {
+  firstId_ = firstId;
+  numFeatures_ = numFeatures;
+  storeValues_ = storeValues && numFeatures > 0;
+  wordOffsets_.assign(1, 0);
+  words_.clear();
+  kenlmIndices_.clear();
+  costs_.clear();
+  featureValues_.clear();
+  flags_.clear();
+  coverageOffsets_.assign(1, 0);
+  coverageSize_ = 0;
+  numCoverageBlocks_ = 0;
+  coverageBlocks_.clear();
+  coverageCounts_.clear();
+  deletionCosts_.clear();
+  deletionFeatureValues_.clear();
+  lmBoundaries_.clear();
+  interiorLmScores_.clear();
+  endKenlmStateIndices_.clear();
+  endKenlmStates_.clear();
+}
+
+void NgramTable::swap(NgramTable& other) {
+  std::swap(firstId_, other.firstId_);
+  std::swap(numFeatures_, other.numFeatures_);
+  std::swap(storeValues_, other.storeValues_);
+  wordOffsets_.swap(other.wordOffsets_);
+  words_.swap(other.words_);
+  kenlmIndices_.swap(other.kenlmIndices_);
+  costs_.swap(other.costs_);
+  featureValues_.swap(other.featureValues_);
+  flags_.swap(other.flags_);
+  coverageOffsets_.swap(other.coverageOffsets_);
+  std::swap(coverageSize_, other.coverageSize_);
+  std::swap(numCoverageBlocks_, other.numCoverageBlocks_);
+  coverageBlocks_.swap(other.coverageBlocks_);
+  coverageCounts_.swap(other.coverageCounts_);
+  deletionCosts_.swap(other.deletionCosts_);
+  deletionFeatureValues_.swap(other.deletionFeatureValues_);
+  lmBoundaries_.swap(other.lmBoundaries_);
+  interiorLmScores_.swap(other.interiorLmScores_);
+  endKenlmStateIndices_.swap(other.endKenlmStateIndices_);
+  endKenlmStates_.swap(other.endKenlmStates_);
+}
+
+void NgramTable::add(const Ngram& ngram,
+                     const std::vector<lm::WordIndex>& kenlmIndices,
+                     const std::vector<Coverage>& coverages,
+                     const NgramCosts& costs) {
+  words_.insert(words_.end(), ngram.begin(), ngram.end());
+  kenlmIndices_.insert(kenlmIndices_.end(), kenlmIndices.begin(),
+                       kenlmIndices.end());
+  costs_.insert(costs_.end(), costs.costs.begin(), costs.costs.end());
+  wordOffsets_.push_back(words_.size());
+  flags_.push_back((ngram.front() == STARTSENTENCE ? kStartsWithStart : 0) |
+                   (ngram.back() == ENDSENTENCE ? kEndsWithEnd : 0));
+  for (int i = 0; i < coverages.size(); ++i) {
+    // all the coverages of a table have the size of the input sentence.
+    coverageSize_ = coverages[i].size();
+    numCoverageBlocks_ = coverages[i].numBlocks();
+    coverageBlocks_.insert(coverageBlocks_.end(), coverages[i].data(),
+                           coverages[i].data() + numCoverageBlocks_);
+    coverageCounts_.push_back(coverages[i].count());
+  }
+  coverageOffsets_.push_back(coverageCounts_.size());
+  deletionCosts_.push_back(costs.deletionCost);
+  if (storeValues_) {
+    featureValues_.insert(featureValues_.end(), costs.featureValues.begin(),
+                          costs.featureValues.end());
+    deletionFeatureValues_.insert(deletionFeatureValues_.end(),
+                                  costs.deletionFeatureValues.begin(),
+                                  costs.deletionFeatureValues.end());
+  }
+  lmBoundaries_.push_back(costs.lmBoundary);
+  interiorLmScores_.push_back(costs.interiorLmScore);
+  if (costs.lmBoundary < ngram.size()) {
+    endKenlmStateIndices_.push_back(endKenlmStates_.size());
+    endKenlmStates_.push_back(costs.endKenlmState);
+  } else {
+    endKenlmStateIndices_.push_back(-1);
+  }
+}
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
@@ -0,0 +1,333 @@
+/*
+ * NgramTable.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef NGRAMTABLE_H_
+#define NGRAMTABLE_H_
+
+#include <vector>
+#include <lm/state.hh>
+#include <lm/word_index.hh>
+
+#include "Types.h"
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+/**
+ * Costs of an n-gram that do not depend on the state it extends: the cost of
+ * the features, which only depend on the n-gram, and the language model score
+ * of the words whose history is within the n-gram. In case of overlap, the
+ * first words of the n-gram are not applied, so costs are given for each
+ * number of words removed (the offset).
+ */
+struct NgramCosts {
+  /** Weighted feature cost for each offset. */
+  std::vector<Cost> costs;
+  /** Feature values for each offset, only computed in tuning. */
+  std::vector<float> featureValues;
+  /** Weighted feature cost of the deletion of the last word. Deletions only
+   * apply to unigrams, i.e. to the last word of the n-gram. */
+  Cost deletionCost;
+  /** Feature values of the deletion of the last word, only computed in
+   * tuning. */
+  std::vector<float> deletionFeatureValues;
+  /** Number of words at the beginning of the n-gram whose language model
+   * score depends on the history. Equal to the n-gram size if no score is
+   * precomputed. */
+  int lmBoundary;
+  /** Language model score (log10) of the words from lmBoundary on. */
+  float interiorLmScore;
+  /** KenLM state after the n-gram, if lmBoundary is less than the n-gram
+   * size. */
+  lm::ngram::State endKenlmState;
+};
+
+/**
+ * The n-grams of a chunk with their coverages and costs, stored contiguously:
+ * the words, KenLM indices, per offset costs and coverages of all the n-grams
+ * are each stored in one pool and n-grams are indices into the pools, in the
+ * lexicographic order of their words. Coverages are stored as their blocks
+ * only, with the layout of NgramBinaryReader, so that a coverage takes one
+ * block for sentences of up to 64 words. Per n-gram flags and per coverage
+ * population counts are precomputed so that the search iterates the table
+ * linearly without touching the words.
+ */
+class NgramTable {
+public:
+  /**
+   * Constructor. Creates an empty table.
+   */
+  NgramTable();
+
+  /**
+   * Empties the table.
+   * @param firstId The id of the first n-gram. Ids are unique within a loader.
+   * @param numFeatures The number of features.
+   * @param storeValues Whether feature values are stored as well as costs.
+   */
+  void clear(const int firstId, const int numFeatures, const bool storeValues);
+
+  /**
+   * Swaps the content of two tables. Swapping with an empty table releases
+   * the memory of a table.
+   * @param other The other table.
+   */
+  void swap(NgramTable& other);
+
+  /**
+   * Adds an n-gram. N-grams must be added in lexicographic order.
+   * @param ngram The n-gram.
+   * @param kenlmIndices The KenLM indices of the words of the n-gram.
+   * @param coverages The coverages of the n-gram. There may be multiple
+   * coverages if a word in the input is repeated.
+   * @param costs The costs of the n-gram.
+   */
+  void add(const Ngram& ngram, const std::vector<lm::WordIndex>& kenlmIndices,
+           const std::vector<Coverage>& coverages, const NgramCosts& costs);
+
+  /**
+   * Getter.
+   * @return The number of n-grams.
+   */
+  int size() const {
+    return lmBoundaries_.size();
+  }
+
+  /**
+   * Gets the id of an n-gram, unique within a loader.
+   * @param ngram The n-gram index.
+   * @return The id.
+   */
+  int id(const int ngram) const {
+    return firstId_ + ngram;
+  }
+
+  /**
+   * Gets the number of words of an n-gram.
+   * @param ngram The n-gram index.
+   * @return The number of words.
+   */
+  int ngramSize(const int ngram) const {
+    return wordOffsets_[ngram + 1] - wordOffsets_[ngram];
+  }
+
+  /**
+   * Gets the words of an n-gram.
+   * @param ngram The n-gram index.
+   * @return The first word.
+   */
+  const int* words(const int ngram) const {
+    return &words_[wordOffsets_[ngram]];
+  }
+
+  /**
+   * Gets the KenLM indices of the words of an n-gram.
+   * @param ngram The n-gram index.
+   * @return The index of the first word.
+   */
+  const lm::WordIndex* kenlmIndices(const int ngram) const {
+    return &kenlmIndices_[wordOffsets_[ngram]];
+  }
+
+  /**
+   * Checks if an n-gram starts with a start-of-sentence marker.
+   * @param ngram The n-gram index.
+   * @return True if the first word is a start-of-sentence marker.
+   */
+  bool startsWithStart(const int ngram) const {
+    return flags_[ngram] & kStartsWithStart;
+  }
+
+  /**
+   * Checks if an n-gram ends with an end-of-sentence marker.
+   * @param ngram The n-gram index.
+   * @return True if the last word is an end-of-sentence marker.
+   */
+  bool endsWithEnd(const int ngram) const {
+    return flags_[ngram] & kEndsWithEnd;
+  }
+
+  /**
+   * Gets the coverages of an n-gram, which are consecutive in the coverage
+   * pool.
+   * @param ngram The n-gram index.
+   * @return The index of the first coverage.
+   */
+  int coverageBegin(const int ngram) const {
+    return coverageOffsets_[ngram];
+  }
+
+  /**
+   * Gets the end of the coverages of an n-gram.
+   * @param ngram The n-gram index.
+   * @return The index after the last coverage.
+   */
+  int coverageEnd(const int ngram) const {
+    return coverageOffsets_[ngram + 1];
+  }
+
+  /**
+   * Gets the blocks of a coverage.
+   * @param coverage The coverage index.
+   * @return The blocks, in the layout of Coverage.
+   */
+  const Coverage::Block* coverageBlocks(const int coverage) const {
+    return &coverageBlocks_[coverage * numCoverageBlocks_];
+  }
+
+  /**
+   * Copies a coverage. The memory of the result is reused, so copying into
+   * the same coverage does not allocate.
+   * @param coverage The coverage index.
+   * @param res The coverage.
+   */
+  void coverage(const int coverage, Coverage* res) const {
+    res->assign(coverageBlocks(coverage), coverageSize_);
+  }
+
+  /**
+   * Gets the number of bits set in a coverage.
+   * @param coverage The coverage index.
+   * @return The number of bits set.
+   */
+  int coverageCount(const int coverage) const {
+    return coverageCounts_[coverage];
+  }
+
+  /**
+   * Gets the weighted feature cost of an n-gram applied from an offset.
+   * @param ngram The n-gram index.
+   * @param offset The number of words removed from the beginning.
+   * @return The cost.
+   */
+  Cost cost(const int ngram, const int offset) const {
+    return costs_[wordOffsets_[ngram] + offset];
+  }
+
+  /**
+   * Gets the feature values of an n-gram applied from an offset.
+   * @param ngram The n-gram index.
+   * @param offset The number of words removed from the beginning.
+   * @return The feature values, NULL if they are not stored.
+   */
+  const float* values(const int ngram, const int offset) const {
+    return featureValues_.empty() ? NULL :
+        &featureValues_[(wordOffsets_[ngram] + offset) * numFeatures_];
+  }
+
+  /**
+   * Gets the weighted feature cost of the deletion of the last word of an
+   * n-gram.
+   * @param ngram The n-gram index.
+   * @return The cost.
+   */
+  Cost deletionCost(const int ngram) const {
+    return deletionCosts_[ngram];
+  }
+
+  /**
+   * Gets the feature values of the deletion of the last word of an n-gram.
+   * @param ngram The n-gram index.
+   * @return The feature values, NULL if they are not stored.
+   */
+  const float* deletionValues(const int ngram) const {
+    return deletionFeatureValues_.empty() ? NULL :
+        &deletionFeatureValues_[ngram * numFeatures_];
+  }
+
+  /**
+   * Gets the number of words at the beginning of an n-gram whose language
+   * model score depends on the history.
+   * @param ngram The n-gram index.
+   * @return The number of words.
+   */
+  int lmBoundary(const int ngram) const {
+    return lmBoundaries_[ngram];
+  }
+
+  /**
+   * Gets the language model score of the words of an n-gram from the
+   * boundary on.
+   * @param ngram The n-gram index.
+   * @return The score (log10).
+   */
+  float interiorLmScore(const int ngram) const {
+    return interiorLmScores_[ngram];
+  }
+
+  /**
+   * Gets the KenLM state after an n-gram.
+   * @param ngram The n-gram index.
+   * @return The state, NULL unless the boundary is less than the n-gram size.
+   */
+  const lm::ngram::State* endKenlmState(const int ngram) const {
+    return endKenlmStateIndices_[ngram] < 0 ? NULL :
+        &endKenlmStates_[endKenlmStateIndices_[ngram]];
+  }
+
+private:
+  enum {
+    kStartsWithStart = 1,
+    kEndsWithEnd = 2
+  };
+
+  /** Id of the first n-gram. */
+  int firstId_;
+  /** Number of features. */
+  int numFeatures_;
+  /** Whether feature values are stored. */
+  bool storeValues_;
+
+  /** Offset of the words of each n-gram, plus the total number of words. */
+  std::vector<int> wordOffsets_;
+  /** Words of all n-grams. */
+  std::vector<int> words_;
+  /** KenLM indices of the words of all n-grams. */
+  std::vector<lm::WordIndex> kenlmIndices_;
+  /** Feature cost of each n-gram and offset, aligned with the words. */
+  std::vector<Cost> costs_;
+  /** Feature values of each n-gram and offset, numFeatures_ values per
+   * word. Empty if the values are not stored. */
+  std::vector<float> featureValues_;
+  /** Start and end of sentence flags of each n-gram. */
+  std::vector<unsigned char> flags_;
+
+  /** Offset of the coverages of each n-gram, plus the total number of
+   * coverages. */
+  std::vector<int> coverageOffsets_;
+  /** Number of bits of the coverages, the input sentence size. */
+  int coverageSize_;
+  /** Number of blocks of each coverage. */
+  int numCoverageBlocks_;
+  /** Blocks of the coverages of all n-grams, numCoverageBlocks_ blocks per
+   * coverage. */
+  std::vector<Coverage::Block> coverageBlocks_;
+  /** Number of bits set in each coverage. */
+  std::vector<int> coverageCounts_;
+
+  /** Deletion cost of each n-gram. */
+  std::vector<Cost> deletionCosts_;
+  /** Deletion feature values of each n-gram. Empty if the values are not
+   * stored. */
+  std::vector<float> deletionFeatureValues_;
+  /** Language model boundary of each n-gram. */
+  std::vector<int> lmBoundaries_;
+  /** Interior language model score of each n-gram. */
+  std::vector<float> interiorLmScores_;
+  /** Index of the KenLM state after each n-gram in endKenlmStates_, minus
+   * one if the state is not precomputed. */
+  std::vector<int> endKenlmStateIndices_;
+  /** KenLM states after the n-grams whose boundary is less than their
+   * size. */
+  std::vector<lm::ngram::State> endKenlmStates_;
+};
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
+
+#endif /* NGRAMTABLE_H_ */
@@ -16,17 +16,13 @@ namespace cam {
 namespace eng {
 namespace gen {
 
-State::State(const StateId stateId, StateKey* stateKey, const Cost cost,
+State::State(const StateId stateId, const StateKey& stateKey, const Cost cost,
              const Cost futureCost, bool hasInput)
   : stateId_(stateId), stateKey_(stateKey), cost_(cost),
     futureCost_(futureCost), hasInput_(hasInput) {}
 
-State::~State() {
-  delete stateKey_;
-}
-
 bool State::isInitial() const {
-  return (stateKey_->coverage_.none());
+  return (stateKey_.coverage_.none());
 }
 
 const fst::StdArc::StateId State::stateId() const {
@@ -42,15 +38,15 @@ const Cost State::futureCost() const {
 }
 
 const Coverage& State::coverage() const {
-  return stateKey_->coverage_;
+  return stateKey_.coverage_;
 }
 
-const StateKey* State::stateKey() const {
+const StateKey& State::stateKey() const {
   return stateKey_;
 }
 
 const lm::ngram::State& State::getKenlmState() const {
-  return stateKey_->kenlmState_;
+  return stateKey_.kenlmState_;
 }
 
 const bool State::hasInput() const {
@@ -61,6 +57,11 @@ void State::setHasInput(bool hasInput) {
   hasInput_ = hasInput;
 }
 
+void State::setCost(const Cost cost, const Cost futureCost) {
+  cost_ = cost;
+  futureCost_ = futureCost;
+}
+
 } // namespace gen
 } // namespace eng
 } // namespace cam
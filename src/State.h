@@ -10,20 +10,13 @@
 
 #include <fst/fstlib.h>
 
+#include "StateKey.h"
 #include "Types.h"
 
-namespace lm {
-namespace ngram {
-class State;
-}
-}
-
 namespace cam {
 namespace eng {
 namespace gen {
 
-class StateKey;
-
 class State {
 public:
   typedef fst::StdArc::StateId StateId;
@@ -35,14 +28,9 @@ public:
    * @param futureCost The future cost.
    * @param hasInput Whether the input has been recovered so far.
    */
-  State(const StateId stateId, StateKey* key, const Cost cost,
+  State(const StateId stateId, const StateKey& key, const Cost cost,
         const Cost futureCost, const bool hasInput);
 
-  /**
-   * Destructor. Custom destructor to delete the state key pointer.
-   */
-  ~State();
-
   /**
    * Checks if a state is initial, that is if the coverage has no bit set.
    * @return True if the coverage has no bit set, false otherwise.
@@ -77,7 +65,7 @@ public:
    * Getter.
    * @return The state key.
    */
-  const StateKey* stateKey() const;
+  const StateKey& stateKey() const;
 
   /**
    * Getter.
@@ -97,11 +85,18 @@ public:
    */
   void setHasInput(bool hasInput);
 
+  /**
+   * Setter. Used when a better path to this state is found.
+   * @param cost The cost.
+   * @param futureCost The future cost.
+   */
+  void setCost(const Cost cost, const Cost futureCost);
+
 private:
   /** The state id in openfst. */
   StateId stateId_;
   /** A state key (pair coverage/history) that uniquely defines this state. */
-  StateKey* stateKey_;
+  StateKey stateKey_;
   /** The best cost so far, or shortest distance from the initial state.
    * This takes into account the future cost. */
   Cost cost_;
@@ -10,13 +10,6 @@
 #include <iostream>
 #include <boost/functional/hash.hpp>
 
-namespace boost {
-template <typename B, typename A>
-std::size_t hash_value(const dynamic_bitset<B, A>& bs) {
-  return hash_value(bs.m_bits);
-}
-} // namespace boost
-
 namespace cam {
 namespace eng {
 namespace gen {
@@ -43,13 +36,18 @@ const Coverage& StateKey::coverage() const {
   return coverage_;
 }
 
-std::size_t hash_value(const StateKey& stateKey) {
+/*static*/ std::size_t StateKey::hash(const Coverage& coverage,
+                                      const lm::ngram::State& kenlmState) {
   std::size_t seed = 0;
-  boost::hash_combine(seed, stateKey.coverage_);
-  boost::hash_combine(seed, stateKey.kenlmState_);
+  boost::hash_combine(seed, coverage);
+  boost::hash_combine(seed, kenlmState);
   return seed;
 }
 
+std::size_t hash_value(const StateKey& stateKey) {
+  return StateKey::hash(stateKey.coverage_, stateKey.kenlmState_);
+}
+
 } // namespace gen
 } // namespace eng
 } // namespace cam
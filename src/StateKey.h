@@ -48,6 +48,17 @@ public:
    */
   const Coverage& coverage() const;
 
+  /**
+   * Computes the hash value of a state key from its parts, without building
+   * the state key.
+   * @param coverage The coverage.
+   * @param kenlmState The history.
+   * @return The hash value, equal to hash_value(StateKey(coverage,
+   * kenlmState)).
+   */
+  static std::size_t hash(const Coverage& coverage,
+                          const lm::ngram::State& kenlmState);
+
 private:
   /** Coverage of the input so far. */
   Coverage coverage_;
@@ -13,17 +13,14 @@
  */
 
 #include <set>
-// this is to be able to use the raw bits as input to a hash function
-#define BOOST_DYNAMIC_BITSET_DONT_USE_FRIENDS
-#include "boost/dynamic_bitset.hpp"
+#include <vector>
+
+#include "Coverage.h"
 
 namespace cam {
 namespace eng {
 namespace gen {
 
-/** Coverage vector of the input */
-typedef boost::dynamic_bitset<> Coverage;
-
 /** Cost. Could use a double if needed. */
 typedef float Cost;
 
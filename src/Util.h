@@ -24,15 +24,6 @@ enum {
   ENDSENTENCE = 2
 };
 
-/**
- * Utility to compute the index in kenlm vocab from an integer id. This is a
- * bit inefficient. It should be possible to reuse the id directly.
- * @param vocab The kenlm language model internal vocabulary
- * @param id The id corresponding to a word via our own wordmap
- * @return The index in kenlm vocab corresponding to the id.
- */
-const lm::WordIndex index(const lm::ngram::Vocabulary& vocab, int id);
-
 /**
  * Utility to print a vector.
  * @param vec The vector to be printed.
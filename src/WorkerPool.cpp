@@ -0,0 +1,85 @@
+/*
+ * WorkerPool.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "WorkerPool.h"
+
+#include <boost/bind.hpp>
+#include <glog/logging.h>
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+WorkerPool::WorkerPool(const int numWorkers) :
+    numWorkers_(numWorkers), tasks_(NULL), numTasks_(0), batch_(0),
+    pending_(0), stopped_(false) {
+  for (int i = 0; i < numWorkers_; ++i) {
+    workers_.create_thread(boost::bind(&WorkerPool::work, this, i));
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    stopped_ = true;
+    started_.notify_all();
+  }
+  workers_.join_all();
+}
+
+void WorkerPool::run(const std::vector<boost::function<void ()> >& tasks) {
+  if (tasks.empty()) {
+    return;
+  }
+  CHECK_LE(tasks.size(), numWorkers_ + 1) << "Too many tasks for the pool";
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    tasks_ = &tasks;
+    numTasks_ = tasks.size();
+    pending_ = tasks.size() - 1;
+    ++batch_;
+    started_.notify_all();
+  }
+  tasks[0]();
+  boost::mutex::scoped_lock lock(mutex_);
+  while (pending_ > 0) {
+    done_.wait(lock);
+  }
+}
+
+void WorkerPool::work(const int worker) {
+  int lastBatch = 0;
+  while (true) {
+    const boost::function<void ()>* task = NULL;
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      while (!stopped_ && batch_ == lastBatch) {
+        started_.wait(lock);
+      }
+      if (stopped_) {
+        return;
+      }
+      lastBatch = batch_;
+      // the calling thread runs the first task. A worker without a task
+      // waits for the next batch: the batch does not wait for it, so the
+      // tasks may already be gone and are not accessed.
+      if (worker + 1 < numTasks_) {
+        task = &(*tasks_)[worker + 1];
+      }
+    }
+    if (task) {
+      (*task)();
+      boost::mutex::scoped_lock lock(mutex_);
+      if (--pending_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+}
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
@@ -0,0 +1,89 @@
+/*
+ * WorkerPool.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef WORKERPOOL_H_
+#define WORKERPOOL_H_
+
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+/**
+ * Fixed set of threads that run batches of tasks. The threads are created
+ * once and wait on a condition variable between batches, so that running a
+ * batch does not create any thread.
+ */
+class WorkerPool {
+public:
+  /**
+   * Constructor. Starts the threads.
+   * @param numWorkers The number of threads. A batch runs at most
+   * numWorkers + 1 tasks since the calling thread runs one of them.
+   */
+  explicit WorkerPool(const int numWorkers);
+
+  /**
+   * Destructor. Stops and joins the threads.
+   */
+  ~WorkerPool();
+
+  /**
+   * Getter.
+   * @return The number of threads.
+   */
+  int numWorkers() const {
+    return numWorkers_;
+  }
+
+  /**
+   * Runs a batch of tasks and waits until they are all done. The first task
+   * is run by the calling thread and the others by the threads of the pool.
+   * @param tasks The tasks, at most numWorkers + 1.
+   */
+  void run(const std::vector<boost::function<void ()> >& tasks);
+
+private:
+  /**
+   * Worker loop. Waits for a batch, runs the task of the worker if there is
+   * one, and signals its completion.
+   * @param worker The index of the worker.
+   */
+  void work(const int worker);
+
+  /** Number of threads. */
+  int numWorkers_;
+  /** Tasks of the current batch. */
+  const std::vector<boost::function<void ()> >* tasks_;
+  /** Number of tasks of the current batch. */
+  int numTasks_;
+  /** Incremented for each batch. */
+  int batch_;
+  /** Number of tasks of the current batch run by the workers and not yet
+   * done. */
+  int pending_;
+  /** Whether the workers must stop. */
+  bool stopped_;
+  /** Protects all the fields above. */
+  boost::mutex mutex_;
+  /** Signaled when a batch starts or when the workers must stop. */
+  boost::condition_variable started_;
+  /** Signaled when the tasks of a batch are done. */
+  boost::condition_variable done_;
+  /** The threads. */
+  boost::thread_group workers_;
+};
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
+
+#endif /* WORKERPOOL_H_ */
@@ -0,0 +1,49 @@
+/*
+ * FeatureSet.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "features/FeatureSet.h"
+
+#include "features/FeatureFactory.h"
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+FeatureSet::FeatureSet(const std::vector<std::string>& featureNames,
+                       const Weights& weights) {
+  for (int i = 0; i < featureNames.size(); ++i) {
+    features_.push_back(FeatureFactory::createFeature(featureNames[i]));
+    weights_.push_back(weights.getWeight(featureNames[i]));
+  }
+}
+
+Cost FeatureSet::cost(const Ngram& rule, float* values) const {
+  Cost res = 0;
+  for (int i = 0; i < features_.size(); ++i) {
+    float value = features_[i]->getValue(rule);
+    res += value * weights_[i];
+    if (values) {
+      values[i] = value;
+    }
+  }
+  return res;
+}
+
+Cost FeatureSet::deletionCost(const Ngram& rule, float* values) const {
+  Cost res = 0;
+  for (int i = 0; i < features_.size(); ++i) {
+    float value = features_[i]->getValueDeletion(rule);
+    res += value * weights_[i];
+    if (values) {
+      values[i] = value;
+    }
+  }
+  return res;
+}
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
@@ -0,0 +1,107 @@
+/*
+ * FeatureSet.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef FEATURESET_H_
+#define FEATURESET_H_
+
+#include <string>
+#include <vector>
+#include <boost/smart_ptr.hpp>
+
+#include "features/Feature.h"
+#include "features/Weights.h"
+
+namespace cam {
+namespace eng {
+namespace gen {
+
+/**
+ * The features selected for decoding, resolved once from their names, with
+ * their weights in a parallel array. Feature i is stored in the sparse tuple
+ * weight parameter slot(i). The language model is stored in slot
+ * kLanguageModelSlot and always has weight one.
+ */
+class FeatureSet {
+public:
+  enum {
+    /** Sparse tuple weight parameter for the language model. Parameter zero
+     * is reserved by TropicalSparseTupleWeight. */
+    kLanguageModelSlot = 1,
+    /** Sparse tuple weight parameter for the first feature. */
+    kFirstFeatureSlot = 2
+  };
+
+  /**
+   * Constructor. Creates the feature objects and looks up their weights.
+   * @param featureNames The feature names.
+   * @param weights The feature weights.
+   */
+  FeatureSet(const std::vector<std::string>& featureNames,
+             const Weights& weights);
+
+  /**
+   * Getter.
+   * @return The number of features.
+   */
+  int size() const {
+    return features_.size();
+  }
+
+  /**
+   * Gets a feature.
+   * @param i The feature index.
+   * @return The feature.
+   */
+  const Feature& feature(const int i) const {
+    return *features_[i];
+  }
+
+  /**
+   * Gets the weight of a feature.
+   * @param i The feature index.
+   * @return The weight.
+   */
+  float weight(const int i) const {
+    return weights_[i];
+  }
+
+  /**
+   * Computes the weighted cost of the features for a rule.
+   * @param rule The rule.
+   * @param values If not NULL, receives the size() feature values.
+   * @return The dot product feature values/feature weights.
+   */
+  Cost cost(const Ngram& rule, float* values) const;
+
+  /**
+   * Computes the weighted cost of the features for a deletion rule.
+   * @param rule The rule.
+   * @param values If not NULL, receives the size() deletion feature values.
+   * @return The dot product feature values/feature weights.
+   */
+  Cost deletionCost(const Ngram& rule, float* values) const;
+
+  /**
+   * Gets the sparse tuple weight parameter of a feature.
+   * @param i The feature index.
+   * @return The parameter index.
+   */
+  static int slot(const int i) {
+    return kFirstFeatureSlot + i;
+  }
+
+private:
+  /** The features. */
+  std::vector<boost::shared_ptr<Feature> > features_;
+  /** The weight of each feature. */
+  std::vector<float> weights_;
+};
+
+} // namespace gen
+} // namespace eng
+} // namespace cam
+
+#endif /* FEATURESET_H_ */
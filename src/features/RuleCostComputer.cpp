@@ -7,6 +7,7 @@
 
 #include "features/RuleCostComputer.h"
 
+#include <algorithm>
 #include <glog/logging.h>
 
 #include "Util.h"
@@ -17,18 +18,19 @@ namespace eng {
 namespace gen {
 
 Cost lmCost(const State& state, const Ngram& rule,
-            boost::shared_ptr<lm::ngram::Model> languageModel,
+            const PrecomputedRule& precomputed,
+            const LanguageModel& languageModel,
             lm::ngram::State* nextKenlmState) {
   Cost res = 0;
   lm::ngram::State startKenlmStateTemp;
-  const lm::ngram::Vocabulary& vocab = languageModel->GetVocabulary();
-  for (int i = 0; i < rule.size(); i++) {
+  const int boundary = std::min<int>(precomputed.boundary, rule.size());
+  for (int i = 0; i < boundary; i++) {
     if (rule[i] == STARTSENTENCE) {
       CHECK_EQ(0, i) << "Ngram with a start-of-sentence marker in the middle.";
-      startKenlmStateTemp = languageModel->BeginSentenceState();
+      startKenlmStateTemp = languageModel.BeginSentenceState();
       // corner case where the rule is just start of sentence
       if (rule.size() == 1) {
-        *nextKenlmState = languageModel->BeginSentenceState();
+        *nextKenlmState = languageModel.BeginSentenceState();
       }
       continue;
     }
@@ -39,9 +41,13 @@ Cost lmCost(const State& state, const Ngram& rule,
     }
     // else startKenlmStateTemp has been set to
     // languageModel_->BeginSentenceState()
-    res += languageModel->Score(
-        startKenlmStateTemp, index(languageModel->GetVocabulary(), rule[i]),
-        *nextKenlmState);
+    res += languageModel.Score(startKenlmStateTemp,
+                               precomputed.kenlmIndices[i], *nextKenlmState);
+  }
+  if (boundary < rule.size()) {
+    // the history of the remaining words is within the rule.
+    res += precomputed.interiorLmScore;
+    *nextKenlmState = *precomputed.endKenlmState;
   }
   return res * (-log(10));
 }
@@ -17,8 +17,7 @@
 #include <lm/model.hh>
 
 #include "features/Feature.h"
-#include "features/FeatureFactory.h"
-#include "features/Weights.h"
+#include "features/FeatureSet.h"
 
 #include "include/params.h"
 #include "include/tropical-sparse-tuple-weight-incls.h"
@@ -26,6 +25,7 @@
 #include "include/tropical-sparse-tuple-weight-decls.h"
 #include "include/tropical-sparse-tuple-weight.makeweight.h"
 
+#include "LanguageModel.h"
 #include "Types.h"
 
 namespace cam {
@@ -34,17 +34,42 @@ namespace gen {
 
 class State;
 
+/**
+ * Everything about a rule that does not depend on the state the rule is
+ * applied from. This is computed once when the n-grams are loaded.
+ */
+struct PrecomputedRule {
+  /** KenLM indices of the words of the rule. */
+  const lm::WordIndex* kenlmIndices;
+  /** Number of words at the beginning of the rule whose language model score
+   * depends on the history. If less than the rule size, the words from the
+   * boundary on are scored by interiorLmScore. */
+  int boundary;
+  /** Language model score (log10) of the words from the boundary. */
+  float interiorLmScore;
+  /** KenLM state after the rule. Only used if the boundary is less than the
+   * rule size. */
+  const lm::ngram::State* endKenlmState;
+  /** Weighted feature cost of the rule. */
+  Cost featureCost;
+  /** Feature values of the rule. NULL if they are not stored. */
+  const float* featureValues;
+};
+
 /**
  * Computes the language model cost of a rule starting in a certain state
- * (with a certain history).
+ * (with a certain history). Only the words before the boundary of the rule
+ * are scored, the score of the other words is precomputed.
  * @param state The state we start from.
  * @param rule The rule we apply.
+ * @param precomputed The precomputed part of the rule cost.
  * @param languageModel The language model.
  * @param nextKenlmState The kenlm state we end up in.
  * @return The language model cost for the rule.
  */
 Cost lmCost(const State& state, const Ngram& rule,
-            boost::shared_ptr<lm::ngram::Model> languageModel,
+            const PrecomputedRule& precomputed,
+            const LanguageModel& languageModel,
             lm::ngram::State* nextKenlmState);
 
 /**
@@ -61,32 +86,26 @@ Cost lmCostDeletion(const State& state, const Ngram& rule,
  * Struct to compute rule cost and the rule weight. The cost is always the dot
  * product feature values/feature weights. The weight depends on the template.
  * In the standard semiring, the weight is equal to the cost. In the sparse
- * tuple weight semiring, the cost is the vector of feature values.
+ * tuple weight semiring, the cost is the vector of feature values. The feature
+ * costs only depend on the rule so they are computed beforehand (see
+ * NgramLoader) and only the language model cost is computed here.
  */
 template <class Arc = fst::StdArc>
 struct RuleCostAndWeightComputer {
   /**
    * Computes the cost for a normal rule.
-   * @param state The start state.
-   * @param rule The rule.
-   * @param weights The feature weights.
-   * @param featureNames The list of feature names.
-   * @param languageModel The language model.
-   * @param nextKenlmState The kenlm state we end up in.
+   * @param languageModelCost The language model cost of the rule, computed by
+   * lmCost().
+   * @param precomputed The precomputed part of the rule cost. The feature
+   * values are not used in the std semiring.
+   * @param featureSet The features and their weights.
    * @param weight The weight (cost for std semiring)
    * @return The cost of the rule.
    */
   const Cost compute(
-      const State& state, const Ngram& rule, const Weights& weights,
-      const std::vector<std::string>& featureNames,
-      boost::shared_ptr<lm::ngram::Model> languageModel,
-      lm::ngram::State* nextKenlmState, typename Arc::Weight* weight) {
-    Cost res = lmCost(state, rule, languageModel, nextKenlmState);
-    for (int i = 0; i < featureNames.size(); ++i) {
-      boost::shared_ptr<Feature> feature =
-          FeatureFactory::createFeature(featureNames[i]);
-      res += feature->getValue(rule) * weights.getWeight(featureNames[i]);
-    }
+      const Cost languageModelCost, const PrecomputedRule& precomputed,
+      const FeatureSet& featureSet, typename Arc::Weight* weight) {
+    Cost res = languageModelCost + precomputed.featureCost;
     *weight = res;
     return res;
   }
@@ -95,23 +114,19 @@ struct RuleCostAndWeightComputer {
    * Computes the cost for a deletion rule.
    * @param state The start state.
    * @param rule The rule.
-   * @param weights The feature weights.
-   * @param featureNames The list of feature names.
+   * @param featureCost The weighted deletion feature cost of the rule.
+   * @param featureValues The deletion feature values of the rule. Not used in
+   * the std semiring.
+   * @param featureSet The features and their weights.
    * @param nextKenlmState The kenlm state we end up in.
    * @param weight The weight (cost for std semiring).
    * @return The cost of the deletion rule.
    */
   const Cost computeDeletion(
-      const State& state, const Ngram& rule, const Weights& weights,
-      const std::vector<std::string>& featureNames,
+      const State& state, const Ngram& rule, const Cost featureCost,
+      const float* featureValues, const FeatureSet& featureSet,
       lm::ngram::State* nextKenlmState, typename Arc::Weight* weight) {
-    Cost res = lmCostDeletion(state, rule, nextKenlmState);
-    for (int i = 0; i < featureNames.size(); ++i) {
-      boost::shared_ptr<Feature> feature =
-          FeatureFactory::createFeature(featureNames[i]);
-      res +=
-          feature->getValueDeletion(rule) * weights.getWeight(featureNames[i]);
-    }
+    Cost res = lmCostDeletion(state, rule, nextKenlmState) + featureCost;
     *weight = res;
     return res;
   }
@@ -124,62 +139,50 @@ template <>
 struct RuleCostAndWeightComputer<TupleArc32> {
   /**
    * Computes the cost for a normal rule.
-   * @param state The start state.
-   * @param rule The rule.
-   * @param weights The feature weights.
-   * @param featureNames The list of feature names.
-   * @param languageModel The language model.
-   * @param nextKenlmState The kenlm state we end up in.
+   * @param languageModelCost The language model cost of the rule, computed by
+   * lmCost().
+   * @param precomputed The precomputed part of the rule cost.
+   * @param featureSet The features and their weights.
    * @param weight The weight (vector of feature values in sparse tuple weight
    * semiring)
    * @return The cost of the rule.
    */
   const Cost compute(
-      const State& state, const Ngram& rule, const Weights& weights,
-      const std::vector<std::string>& featureNames,
-      boost::shared_ptr<lm::ngram::Model> languageModel,
-      lm::ngram::State* nextKenlmState, TupleW32* weight) {
-    Cost res = lmCost(state, rule, languageModel, nextKenlmState);
+      const Cost languageModelCost, const PrecomputedRule& precomputed,
+      const FeatureSet& featureSet, TupleW32* weight) {
     // Warning: here the first index is 1 because 0 is reserved by
     // TropicalSparseTupleWeight
-    weight->Push(1, res);
-    for (int i = 0; i < featureNames.size(); ++i) {
-      boost::shared_ptr<Feature> feature =
-          FeatureFactory::createFeature(featureNames[i]);
-      Cost featureValue = feature->getValue(rule);
-      res += featureValue * weights.getWeight(featureNames[i]);
-      weight->Push(i+2, featureValue);
+    weight->Push(FeatureSet::kLanguageModelSlot, languageModelCost);
+    for (int i = 0; i < featureSet.size(); ++i) {
+      weight->Push(FeatureSet::slot(i), precomputed.featureValues[i]);
     }
-    return res;
+    return languageModelCost + precomputed.featureCost;
   }
 
   /**
    * Computes the cost for a deletion rule.
    * @param state The start state.
    * @param rule The rule.
-   * @param weights The feature weights.
-   * @param featureNames The list of feature names.
+   * @param featureCost The weighted deletion feature cost of the rule.
+   * @param featureValues The deletion feature values of the rule.
+   * @param featureSet The features and their weights.
    * @param nextKenlmState The kenlm state we end up in.
    * @param weight The weight (vector of feature values in sparse tuple weight
    * semiring)
    * @return The cost of the deletion rule.
    */
   const Cost computeDeletion(
-      const State& state, const Ngram& rule, const Weights& weights,
-      const std::vector<std::string>& featureNames,
+      const State& state, const Ngram& rule, const Cost featureCost,
+      const float* featureValues, const FeatureSet& featureSet,
       lm::ngram::State* nextKenlmState, TupleW32* weight) {
     Cost res = lmCostDeletion(state, rule, nextKenlmState);
     // Warning: here the first index is 1 because 0 is reserved by
     // TropicalSparseTupleWeight
-    weight->Push(1, res);
-    for (int i = 0; i < featureNames.size(); ++i) {
-      boost::shared_ptr<Feature> feature =
-          FeatureFactory::createFeature(featureNames[i]);
-      Cost featureValue = feature->getValueDeletion(rule);
-      res += featureValue * weights.getWeight(featureNames[i]);
-      weight->Push(i+2, featureValue);
+    weight->Push(FeatureSet::kLanguageModelSlot, res);
+    for (int i = 0; i < featureSet.size(); ++i) {
+      weight->Push(FeatureSet::slot(i), featureValues[i]);
     }
-    return res;
+    return res + featureCost;
   }
 };
 
@@ -1,211 +0,0 @@
-X X1_X2 X1_X2
-X X1_X2 X2_X1
-X 00011111 6895_70_1696_6_2
-X 00101111 5_6895_1696_6_2
-X 00110111 5_70_1696_6_2
-X 00111110 5_6895_70_1696_6
-X 01010111 6316_70_1696_6_2
-X 01100111 6316_5_1696_6_2
-X 01101101 6316_5_6895_1696_2
-X 01110011 5_70_6316_6_2
-X 01110101 6316_5_70_1696_2
-X 01110110 6316_5_70_1696_6
-X 01110110 70_6316_5_1696_6
-X 10010111 7_70_1696_6_2
-X 10110011 5_70_7_6_2
-X 11010011 7_70_6316_6_2
-X 11100110 7_6316_5_1696_6
-X 11110100 7_6316_5_70_1696
-X 11110100 6316_5_70_1696_7
-X 00001111 6895_1696_6_2
-X 00001111 1696_6895_6_2
-X 00010111 70_1696_6_2
-X 00011101 6895_70_1696_2
-X 00011101 70_6895_1696_2
-X 00011110 6895_70_1696_6
-X 00100111 5_1696_6_2
-X 00100111 1696_5_6_2
-X 00101011 5_6895_6_2
-X 00101101 5_6895_1696_2
-X 00101110 5_6895_1696_6
-X 00110011 5_70_6_2
-X 00110011 70_5_6_2
-X 00110101 5_70_1696_2
-X 00110110 5_70_1696_6
-X 00111100 5_6895_70_1696
-X 01000111 1696_6316_6_2
-X 01010011 70_6316_6_2
-X 01010101 6316_70_1696_2
-X 01010110 6316_70_1696_6
-X 01100011 5_6316_6_2
-X 01100101 6316_5_1696_2
-X 01100110 6316_5_1696_6
-X 01101100 6316_5_6895_1696
-X 01101100 6895_6316_5_1696
-X 01110001 70_6316_5_2
-X 01110010 5_70_6316_6
-X 01110010 6_70_6316_5
-X 01110100 6316_5_70_1696
-X 01110100 70_6316_5_1696
-X 01111000 70_6316_5_6895
-X 10000111 7_1696_6_2
-X 10000111 6_7_1696_2
-X 10001011 7_6895_6_2
-X 10001110 7_6895_1696_6
-X 10010011 7_70_6_2
-X 10010011 70_7_6_2
-X 10010011 6_7_70_2
-X 10010110 7_70_1696_6
-X 10010110 1696_6_7_70
-X 10100011 7_5_6_2
-X 10100011 5_7_6_2
-X 10100011 6_7_5_2
-X 10100110 5_1696_6_7
-X 10101100 5_6895_1696_7
-X 10110001 5_70_7_2
-X 10110010 5_70_7_6
-X 10110100 5_70_1696_7
-X 10110100 5_1696_7_70
-X 11000011 7_6316_6_2
-X 11010001 7_70_6316_2
-X 11010010 7_70_6316_6
-X 11010010 6_7_70_6316
-X 11100001 7_6316_5_2
-X 11100100 1696_7_6316_5
-X 11100100 7_6316_5_1696
-X 11100100 6316_5_1696_7
-X 11101000 7_6316_5_6895
-X 11101000 6316_5_6895_7
-X 11101000 6895_7_6316_5
-X 11110000 7_6316_5_70
-X 11110000 7_70_6316_5
-X 11110000 6316_5_70_7
-X 11110000 5_70_6316_7
-X 00000111 1696_6_2
-X 00000111 6_1696_2
-X 00001011 6895_6_2
-X 00001101 6895_1696_2
-X 00001101 1696_6895_2
-X 00001110 6895_1696_6
-X 00001110 1696_6895_6
-X 00010011 70_6_2
-X 00010011 6_70_2
-X 00010101 70_1696_2
-X 00010110 70_1696_6
-X 00010110 6_70_1696
-X 00010110 1696_6_70
-X 00010110 70_6_1696
-X 00011100 6895_70_1696
-X 00011100 70_6895_1696
-X 00100011 5_6_2
-X 00100011 6_5_2
-X 00100101 5_1696_2
-X 00100101 1696_5_2
-X 00100110 5_1696_6
-X 00100110 1696_6_5
-X 00100110 6_5_1696
-X 00100110 6_1696_5
-X 00100110 1696_5_6
-X 00101001 5_6895_2
-X 00101010 5_6895_6
-X 00101010 6895_6_5
-X 00101100 5_6895_1696
-X 00110001 5_70_2
-X 00110010 6_5_70
-X 00110010 5_70_6
-X 00110010 5_6_70
-X 00110010 70_6_5
-X 00110010 70_5_6
-X 00110100 5_70_1696
-X 00110100 70_1696_5
-X 00110100 1696_5_70
-X 00110100 5_1696_70
-X 00111000 5_6895_70
-X 01000011 6316_6_2
-X 01000011 6_6316_2
-X 01000101 6316_1696_2
-X 01000101 1696_6316_2
-X 01000110 1696_6316_6
-X 01010001 70_6316_2
-X 01010010 70_6316_6
-X 01010010 6_70_6316
-X 01010010 6316_6_70
-X 01010100 6316_70_1696
-X 01100001 6316_5_2
-X 01100001 5_6316_2
-X 01100010 5_6316_6
-X 01100010 6_6316_5
-X 01100010 6316_6_5
-X 01100100 6316_5_1696
-X 01101000 6316_5_6895
-X 01101000 6895_6316_5
-X 01110000 6316_5_70
-X 01110000 70_6316_5
-X 01110000 5_70_6316
-X 01110000 5_6316_70
-X 10000011 7_6_2
-X 10000011 6_7_2
-X 10000101 7_1696_2
-X 10000101 1696_7_2
-X 10000110 7_1696_6
-X 10000110 1696_6_7
-X 10000110 6_1696_7
-X 10000110 6_7_1696
-X 10001010 7_6895_6
-X 10001010 6895_6_7
-X 10001100 7_6895_1696
-X 10001100 6895_1696_7
-X 10010001 7_70_2
-X 10010001 70_7_2
-X 10010010 7_70_6
-X 10010010 6_7_70
-X 10010010 70_6_7
-X 10010010 6_70_7
-X 10010010 70_7_6
-X 10010010 7_6_70
-X 10010100 70_1696_7
-X 10010100 1696_7_70
-X 10010100 7_70_1696
-X 10010100 7_1696_70
-X 10011000 6895_7_70
-X 10100001 7_5_2
-X 10100001 5_7_2
-X 10100010 6_7_5
-X 10100010 5_6_7
-X 10100010 7_5_6
-X 10100010 5_7_6
-X 10100010 7_6_5
-X 10100010 6_5_7
-X 10100100 5_1696_7
-X 10100100 1696_7_5
-X 10100100 7_1696_5
-X 10100100 5_7_1696
-X 10100100 7_5_1696
-X 10101000 5_6895_7
-X 10101000 7_5_6895
-X 10110000 5_70_7
-X 10110000 7_5_70
-X 10110000 5_7_70
-X 10110000 7_70_5
-X 10110000 70_7_5
-X 11000001 7_6316_2
-X 11000001 6316_7_2
-X 11000010 7_6316_6
-X 11000010 6316_6_7
-X 11000010 6_7_6316
-X 11000010 6_6316_7
-X 11000010 6316_7_6
-X 11000100 1696_7_6316
-X 11000100 1696_6316_7
-X 11000100 6316_7_1696
-X 11001000 6895_7_6316
-X 11010000 7_70_6316
-X 11010000 70_6316_7
-X 11010000 6316_7_70
-X 11010000 7_6316_70
-X 11010000 70_7_6316
-X 11100000 7_6316_5
-X 11100000 5_6316_7
-X 11100000 6316_7_5
-X 11100000 6316_5_7
-X 11100000 7_5_6316
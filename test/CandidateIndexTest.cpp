@@ -0,0 +1,105 @@
+/*
+ * CandidateIndexTest.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include <map>
+#include <gtest/gtest.h>
+#include "CandidateIndex.h"
+#include "Util.h"
+
+namespace {
+
+using namespace cam::eng::gen;
+
+class CandidateIndexTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    // input: <s> 3 4 5 </s>
+    add("1_3", "11000");
+    add("3_4", "01100");
+    add("4_3", "01100");
+    add("4_5", "00110");
+    add("3_4_5", "01110");
+    add("5_2", "00011");
+    add("3", "01000");
+    add("3", "00100"); // 3 is repeated in the coverage list on purpose
+    ngrams_.clear(0, 0, false);
+    for (std::map<Ngram, std::vector<Coverage> >::const_iterator it =
+        coverages_.begin(); it != coverages_.end(); ++it) {
+      // KenLM indices are the word ids.
+      std::vector<lm::WordIndex> kenlmIndices(it->first.begin(),
+                                              it->first.end());
+      NgramCosts costs;
+      costs.costs.assign(it->first.size(), 0);
+      costs.deletionCost = 0;
+      costs.lmBoundary = it->first.size();
+      costs.interiorLmScore = 0;
+      ngrams_.add(it->first, kenlmIndices, it->second, costs);
+    }
+    index_.build(ngrams_, 5);
+  }
+
+  void add(const std::string& ngram, const std::string& coverage) {
+    Ngram words;
+    for (int i = 0; i < ngram.size(); i += 2) {
+      words.push_back(ngram[i] - '0');
+    }
+    coverages_[words].push_back(Coverage(coverage));
+  }
+
+  std::string find(const std::string& coverage, const std::string& history,
+                   const bool initial, const int maxOverlap) {
+    // history words, most recent first as in KenLM
+    lm::ngram::State state;
+    state.length = history.size();
+    for (int i = 0; i < history.size(); ++i) {
+      state.words[i] = history[history.size() - 1 - i] - '0';
+    }
+    std::vector<const Candidate*> candidates;
+    index_.find(Coverage(coverage), state, initial, maxOverlap, &scratch_,
+                &candidates);
+    std::string res;
+    for (int i = 0; i < candidates.size(); ++i) {
+      const int ngram = candidates[i]->ngram;
+      res += res.empty() ? "" : " ";
+      for (int j = 0; j < ngrams_.ngramSize(ngram); ++j) {
+        res += '0' + ngrams_.words(ngram)[j];
+      }
+      res += ':';
+      res += '0' + candidates[i]->coverage - ngrams_.coverageBegin(ngram);
+    }
+    return res;
+  }
+
+  std::map<Ngram, std::vector<Coverage> > coverages_;
+  NgramTable ngrams_;
+  CandidateIndex index_;
+  CandidateIndex::Scratch scratch_;
+};
+
+TEST_F(CandidateIndexTest, initial) {
+  EXPECT_EQ("13:0", find("00000", "", true, 0));
+}
+
+TEST_F(CandidateIndexTest, noOverlap) {
+  EXPECT_EQ("3:1 45:0 52:0", find("11000", "13", false, 0));
+  EXPECT_EQ("52:0", find("11100", "134", false, 0));
+}
+
+TEST_F(CandidateIndexTest, overlap) {
+  // table order, overlapping candidates must start with the history.
+  EXPECT_EQ("3:1 34:0 345:0 45:0 52:0", find("11000", "13", false, 1));
+  EXPECT_EQ("3:1 34:0 345:0 45:0 52:0", find("11000", "13", false, 2));
+  EXPECT_EQ("45:0 52:0", find("11100", "134", false, 1));
+  EXPECT_EQ("345:0 45:0 52:0", find("11100", "134", false, 2));
+}
+
+TEST_F(CandidateIndexTest, minimizedHistory) {
+  // KenLM dropped 3 from the history: 345 would overlap two words.
+  EXPECT_EQ("45:0 52:0", find("11100", "4", false, 2));
+  EXPECT_EQ("", find("11110", "", false, 2));
+}
+
+} // namespace
@@ -6,14 +6,109 @@
  */
 
 #include <gtest/gtest.h>
+#include <boost/smart_ptr.hpp>
 #include "Column.h"
+#include "State.h"
 #include "StateKey.h"
 
 namespace {
 
+using cam::eng::gen::Column;
+using cam::eng::gen::Cost;
+using cam::eng::gen::Coverage;
+using cam::eng::gen::State;
+using cam::eng::gen::StateKey;
+
+class ColumnTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    history_.length = 0;
+  }
+
+  /**
+   * Creates a state with a coverage and a cost and adds it to the column.
+   */
+  State* add(const std::string& coverage, const Cost cost) {
+    StateKey key((Coverage(coverage)), history_);
+    states_.push_back(boost::shared_ptr<State>(
+        new State(states_.size(), key, cost, 0, false)));
+    column_.add(states_.back().get(), hash_value(key));
+    return states_.back().get();
+  }
+
+  int find(const std::string& coverage) const {
+    Coverage c(coverage);
+    return column_.find(c, history_, StateKey::hash(c, history_));
+  }
+
+  Column column_;
+  lm::ngram::State history_;
+  std::vector<boost::shared_ptr<State> > states_;
+};
+
 TEST(emptyTest, simple) {
   cam::eng::gen::Column c;
   EXPECT_TRUE(c.empty());
 }
 
+TEST_F(ColumnTest, find) {
+  // enough states to force the index to grow
+  for (int i = 0; i < 64; ++i) {
+    std::string coverage(64, '0');
+    coverage[i] = '1';
+    add(coverage, i);
+  }
+  EXPECT_EQ(64, column_.size());
+  for (int i = 0; i < 64; ++i) {
+    std::string coverage(64, '0');
+    coverage[i] = '1';
+    EXPECT_EQ(i, find(coverage));
+  }
+  EXPECT_EQ(-1, find(std::string(64, '0')));
+}
+
+TEST_F(ColumnTest, pruneKeepsBest) {
+  add("100", 3);
+  add("010", 1);
+  add("001", 2);
+  std::vector<State*> pruned;
+  column_.prune(2, &pruned);
+  ASSERT_EQ(1, pruned.size());
+  EXPECT_EQ(3, pruned[0]->cost());
+  EXPECT_EQ(2, column_.size());
+  EXPECT_EQ(2, column_.pruneCost());
+  EXPECT_EQ(-1, find("100"));
+  EXPECT_LE(0, find("010"));
+  EXPECT_LE(0, find("001"));
+}
+
+TEST_F(ColumnTest, sortAfterUpdate) {
+  add("100", 3);
+  add("010", 1);
+  add("001", 2);
+  column_.updateCost(find("100"), 0, 0);
+  column_.sort();
+  EXPECT_EQ(0, column_.minCost());
+  EXPECT_EQ(0, column_.state(0)->cost());
+  EXPECT_EQ(1, column_.state(1)->cost());
+  EXPECT_EQ(2, column_.state(2)->cost());
+  EXPECT_EQ(0, find("100"));
+}
+
+TEST_F(ColumnTest, release) {
+  State* s1 = add("100", 3);
+  State* s2 = add("010", 1);
+  std::vector<State*> released;
+  column_.release(&released);
+  EXPECT_TRUE(column_.empty());
+  EXPECT_EQ(-1, find("100"));
+  ASSERT_EQ(2, released.size());
+  EXPECT_EQ(s1, released[0]);
+  EXPECT_EQ(s2, released[1]);
+  // the column can be filled again.
+  add("001", 2);
+  EXPECT_EQ(0, find("001"));
+  EXPECT_EQ(2, column_.minCost());
+}
+
 } // namespace
@@ -0,0 +1,72 @@
+/*
+ * CoverageTest.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include <sstream>
+#include <gtest/gtest.h>
+#include "Coverage.h"
+
+namespace {
+
+using cam::eng::gen::Coverage;
+
+TEST(CoverageTest, fromString) {
+  Coverage coverage(std::string("1100"));
+  EXPECT_EQ(4, coverage.size());
+  EXPECT_TRUE(coverage.test(3));
+  EXPECT_TRUE(coverage.test(2));
+  EXPECT_FALSE(coverage.test(1));
+  EXPECT_FALSE(coverage.test(0));
+  EXPECT_EQ(2, coverage.count());
+  std::stringstream ss;
+  ss << coverage;
+  EXPECT_EQ("1100", ss.str());
+}
+
+TEST(CoverageTest, operations) {
+  Coverage c1(std::string("1100"));
+  Coverage c2(std::string("0110"));
+  EXPECT_EQ(Coverage(std::string("0100")), c1 & c2);
+  EXPECT_EQ(Coverage(std::string("1110")), c1 | c2);
+  EXPECT_EQ(1, c1.intersectionCount(c2));
+  EXPECT_FALSE(c2.isSubsetOf(c1));
+  EXPECT_TRUE((c1 & c2).isSubsetOf(c1));
+  EXPECT_TRUE(Coverage(4).none());
+  EXPECT_TRUE(Coverage(4).isSubsetOf(c1));
+}
+
+TEST(CoverageTest, compare) {
+  // same order as boost::dynamic_bitset: most significant bit first.
+  EXPECT_TRUE(Coverage(std::string("0110")) < Coverage(std::string("1000")));
+  EXPECT_TRUE(Coverage(std::string("1001")) > Coverage(std::string("1000")));
+  EXPECT_FALSE(Coverage(std::string("1000")) < Coverage(std::string("1000")));
+  EXPECT_NE(Coverage(std::string("1000")), Coverage(std::string("0001")));
+}
+
+TEST(CoverageTest, longCoverage) {
+  // more bits than the inline storage
+  std::size_t size = Coverage::kInlineBlocks * Coverage::kBitsPerBlock + 10;
+  Coverage c1(size);
+  Coverage c2(size);
+  c1.set(0).set(size - 1);
+  c2.set(size - 1).set(100);
+  EXPECT_EQ(2, c1.count());
+  EXPECT_EQ(1, c1.intersectionCount(c2));
+  Coverage c3(c1);
+  c3 |= c2;
+  EXPECT_EQ(3, c3.count());
+  EXPECT_TRUE(c1.isSubsetOf(c3));
+  c3 = c1;
+  EXPECT_EQ(c1, c3);
+  EXPECT_EQ(hash_value(c1), hash_value(c3));
+  // growing from inline to heap storage keeps the bits
+  Coverage c4(std::string("101"));
+  c4.resize(size);
+  EXPECT_TRUE(c4.test(0));
+  EXPECT_TRUE(c4.test(2));
+  EXPECT_EQ(2, c4.count());
+}
+
+} // namespace
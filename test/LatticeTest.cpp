@@ -1,13 +1,13 @@
 /*
- * ColumnTest.cpp
+ * LatticeTest.cpp
  *
  *  Created on: 21 Nov 2012
  *      Author: jmp84
  */
 
+#include <sstream>
 #include <gtest/gtest.h>
-
-#include <boost/lexical_cast.hpp>
+#include <zlib.h>
 
 #include "Column.h"
 #include "Lattice.h"
@@ -22,49 +22,89 @@ namespace gen {
 class LatticeTest : public ::testing::Test {
 protected:
   virtual void SetUp() {
-    vector<int> input;
+    std::vector<int> input;
     input.push_back(7);
     for (int i = 5; i <= 11; ++i) {
       input.push_back(i);
     }
-    lattice_.reset(new Lattice(input, "test/lm.4.gz"));
+    languageModel_.reset(
+        new LanguageModel("test/lm.4.gz", lm::ngram::Config()));
+    featureSet_.reset(new FeatureSet(std::vector<std::string>(), Weights()));
+    resetLattice(input);
     Coverage coverage(std::string("1111000"));
-    lm::ngram::Model lm("test/lm.4.gz");
-    lm::ngram::State lmState(lm.BeginSentenceState());
-    const lm::ngram::Vocabulary& vocab = lm.GetVocabulary();
+    lm::ngram::State lmState(languageModel_->BeginSentenceState());
     lm::ngram::State nextLmState;
     for (int i = 5; i <= 7; ++i) {
-      lm.Score(lmState, vocab.Index(boost::lexical_cast<std::string>(i)),
-               nextLmState);
+      languageModel_->Score(lmState, languageModel_->index(i), nextLmState);
       lmState = nextLmState;
     }
-    StateKey* stateKey = new StateKey(coverage, nextLmState);
     fst::StdArc::StateId stateId = 0;
-    state_.reset(new State(stateId, stateKey, 0));
+    state_.reset(new State(stateId, StateKey(coverage, lmState), 0, 0, false));
+    ngrams_.clear(0, 0, false);
+  }
+
+  /**
+   * Replaces the lattice with a lattice for another input, without future
+   * costs, transition cache, column release or lazy fst.
+   * @param input The input words.
+   */
+  void resetLattice(const std::vector<int>& input) {
+    lattice_.reset(new Lattice<fst::StdArc>(
+        input, languageModel_, featureSet_, std::vector<Cost>(), 0, false,
+        false));
+  }
+
+  /**
+   * Adds an n-gram with a single coverage to the n-gram table.
+   * @param ngram The n-gram.
+   * @param coverage The coverage of the n-gram.
+   * @return The index of the n-gram in the table.
+   */
+  int addNgram(const Ngram& ngram, const Coverage& coverage) {
+    std::vector<lm::WordIndex> kenlmIndices;
+    lattice_->languageModel_->indices(ngram, &kenlmIndices);
+    NgramCosts costs;
+    costs.costs.assign(ngram.size(), 0);
+    costs.deletionCost = 0;
+    costs.lmBoundary = ngram.size();
+    costs.interiorLmScore = 0;
+    ngrams_.add(ngram, kenlmIndices, std::vector<Coverage>(1, coverage),
+                costs);
+    return ngrams_.size() - 1;
   }
 
   bool compatibleHistory(const State& state, const Ngram& ngram,
                          const Coverage& overlap,
-                         const int overlapCount) const {
-    return lattice_->compatibleHistory(state, ngram, overlap, overlapCount);
+                         const int overlapCount) {
+    const int index = addNgram(ngram, overlap);
+    return lattice_->compatibleHistory(state, ngrams_.words(index),
+                                       ngrams_.kenlmIndices(index), overlap,
+                                       overlapCount);
   }
 
   bool canApply(const State& state, const Ngram& ngram,
                 const Coverage& coverage, const int maxOverlap,
-                Ngram* ngramToApply) const {
-    return lattice_->canApply(state, ngram, coverage, maxOverlap, ngramToApply);
-  }
-
-  const vector<int>& input() const {
-    return lattice_->inputWords_;
+                Ngram* ngramToApply) {
+    const int index = addNgram(ngram, coverage);
+    int overlap;
+    if (!lattice_->canApply(state, ngrams_, index,
+                            ngrams_.coverageBegin(index), maxOverlap,
+                            &overlap)) {
+      return false;
+    }
+    ngramToApply->assign(ngram.begin() + overlap, ngram.end());
+    return true;
   }
 
   const int columnSize(const int index) const {
-    return lattice_->columns_[index].statesSortedByCost_.size();
+    return lattice_->columns_[index].size();
   }
 
-  boost::scoped_ptr<Lattice> lattice_;
+  boost::shared_ptr<LanguageModel> languageModel_;
+  boost::shared_ptr<FeatureSet> featureSet_;
+  boost::scoped_ptr<Lattice<fst::StdArc> > lattice_;
   boost::scoped_ptr<State> state_;
+  NgramTable ngrams_;
 
 };
 
@@ -154,12 +194,39 @@ TEST_F(LatticeTest, canApplyNgramToApply) {
 }
 
 TEST_F(LatticeTest, removePrunedStates) {
-  NgramLoader ngramLoader;
-  ngramLoader.loadNgram("test/1.r");
-  for (int i = 0; i < input().size(); ++i) {
-    lattice_->extend(ngramLoader, i, 1, 0, 0);
+  // input: <s> 5 6 7 </s>, with every unigram and bigram of the input.
+  std::vector<int> input;
+  input.push_back(STARTSENTENCE);
+  for (int i = 5; i <= 7; ++i) {
+    input.push_back(i);
+  }
+  input.push_back(ENDSENTENCE);
+  resetLattice(input);
+  std::ostringstream ngrams;
+  ngrams << "X X1_X2 X1_X2\nX X1_X2 X2_X1\n";
+  for (int i = 0; i < input.size(); ++i) {
+    ngrams << "X " << i << " " << input[i] << "\n";
+    for (int j = 0; j < input.size(); ++j) {
+      if (i != j && input[i] != ENDSENTENCE && input[j] != STARTSENTENCE) {
+        ngrams << "X " << i << "_" << j << " " << input[i] << "_" <<
+            input[j] << "\n";
+      }
+    }
+  }
+  const std::string fileName = testing::TempDir() + "LatticeTest.r.gz";
+  gzFile file = gzopen(fileName.c_str(), "wb");
+  ASSERT_TRUE(file != NULL);
+  gzputs(file, ngrams.str().c_str());
+  gzclose(file);
+  NgramLoader ngramLoader(input, languageModel_, featureSet_, false);
+  ngramLoader.loadNgram(fileName, std::vector<int>(1, input.size()),
+                        std::vector<bool>(1, true), 1, false);
+  for (int i = 0; i < input.size(); ++i) {
+    lattice_->extend(ngramLoader, i, 1, 0, 0, 0, false, 1);
     EXPECT_LE(columnSize(i), 1);
   }
+  // the pruned search still covers the whole input.
+  EXPECT_LT(0, columnSize(input.size()));
 }
 
 } // namespace gen
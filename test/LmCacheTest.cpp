@@ -0,0 +1,69 @@
+/*
+ * LmCacheTest.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include <gtest/gtest.h>
+#include "LmCache.h"
+
+namespace {
+
+using namespace cam::eng::gen;
+
+lm::ngram::State makeState(const lm::WordIndex first,
+                           const lm::WordIndex second) {
+  lm::ngram::State res;
+  res.words[0] = first;
+  res.words[1] = second;
+  res.backoff[0] = 0;
+  res.backoff[1] = 0;
+  res.length = 2;
+  return res;
+}
+
+TEST(LmCacheTest, hitAndMiss) {
+  LmCache cache(16);
+  lm::ngram::State history = makeState(3, 4);
+  lm::ngram::State next = makeState(4, 5);
+  Cost cost;
+  lm::ngram::State found;
+  EXPECT_FALSE(cache.find(history, 7, 0, &cost, &found));
+  cache.insert(history, 7, 0, 1.5, next);
+  ASSERT_TRUE(cache.find(history, 7, 0, &cost, &found));
+  EXPECT_EQ(1.5, cost);
+  EXPECT_TRUE(found == next);
+  // same n-gram applied with a different offset or from another history.
+  EXPECT_FALSE(cache.find(history, 7, 1, &cost, &found));
+  EXPECT_FALSE(cache.find(makeState(3, 6), 7, 0, &cost, &found));
+  EXPECT_EQ(1, cache.hits());
+  EXPECT_EQ(3, cache.misses());
+}
+
+TEST(LmCacheTest, replacement) {
+  // a single slot: every transition replaces the previous one.
+  LmCache cache(1);
+  lm::ngram::State history = makeState(3, 4);
+  Cost cost;
+  lm::ngram::State found;
+  cache.insert(history, 7, 0, 1.5, makeState(4, 5));
+  cache.insert(history, 8, 0, 2.5, makeState(4, 6));
+  EXPECT_FALSE(cache.find(history, 7, 0, &cost, &found));
+  ASSERT_TRUE(cache.find(history, 8, 0, &cost, &found));
+  EXPECT_EQ(2.5, cost);
+  EXPECT_TRUE(found == makeState(4, 6));
+}
+
+TEST(LmCacheTest, disabled) {
+  LmCache cache(0);
+  lm::ngram::State history = makeState(3, 4);
+  Cost cost;
+  lm::ngram::State found;
+  cache.insert(history, 7, 0, 1.5, makeState(4, 5));
+  EXPECT_FALSE(cache.find(history, 7, 0, &cost, &found));
+  // lookups in a disabled cache are not counted.
+  EXPECT_EQ(0, cache.hits());
+  EXPECT_EQ(0, cache.misses());
+}
+
+} // namespace
@@ -0,0 +1,130 @@
+/*
+ * NgramFileTest.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <zlib.h>
+#include "NgramFile.h"
+
+namespace {
+
+using namespace cam::eng::gen;
+
+/**
+ * Compresses data into one gzip member.
+ * @param data The data.
+ * @param level The compression level, 0 to store the data uncompressed.
+ * @return The gzip member.
+ */
+std::string gzipMember(const std::string& data, const int level) {
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  // 16 + MAX_WBITS: gzip header and trailer.
+  EXPECT_EQ(Z_OK, deflateInit2(&stream, level, Z_DEFLATED, 16 + MAX_WBITS, 8,
+                               Z_DEFAULT_STRATEGY));
+  std::string res(deflateBound(&stream, data.size()), '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&res[0]);
+  stream.avail_out = res.size();
+  EXPECT_EQ(Z_STREAM_END, deflate(&stream, Z_FINISH));
+  res.resize(stream.total_out);
+  deflateEnd(&stream);
+  return res;
+}
+
+/**
+ * Decompresses gzip data.
+ * @param data The gzip data.
+ * @param numThreads The number of threads.
+ * @return The decompressed data, or "error" if the data is not valid.
+ */
+std::string gunzipString(const std::string& data, const int numThreads) {
+  std::string res;
+  if (!gunzip(data.data(), data.size(), numThreads, &res)) {
+    return "error";
+  }
+  return res;
+}
+
+/**
+ * Writes a gzipped file.
+ * @param content The content of the file.
+ * @return The file name.
+ */
+std::string writeGzipFile(const std::string& content) {
+  const std::string fileName = testing::TempDir() + "NgramFileTest.r.gz";
+  gzFile file = gzopen(fileName.c_str(), "wb");
+  EXPECT_TRUE(file != NULL);
+  EXPECT_EQ(content.size(), gzwrite(file, content.data(), content.size()));
+  gzclose(file);
+  return fileName;
+}
+
+TEST(NgramFileTest, singleMember) {
+  const std::string gzip = gzipMember("X 0_1 3_4\n", 6);
+  EXPECT_EQ("X 0_1 3_4\n", gunzipString(gzip, 1));
+  EXPECT_EQ("X 0_1 3_4\n", gunzipString(gzip, 4));
+}
+
+TEST(NgramFileTest, multiMember) {
+  const std::string gzip = gzipMember("first\n", 6) +
+      gzipMember("second\n", 6) + gzipMember("third\n", 6);
+  EXPECT_EQ("first\nsecond\nthird\n", gunzipString(gzip, 1));
+  EXPECT_EQ("first\nsecond\nthird\n", gunzipString(gzip, 2));
+  EXPECT_EQ("first\nsecond\nthird\n", gunzipString(gzip, 8));
+}
+
+TEST(NgramFileTest, falseHeader) {
+  // a stored member whose data is itself a gzip member: the inner header
+  // appears in the data of the outer member and must not split it.
+  const std::string inner = gzipMember("inner\n", 6);
+  const std::string gzip = gzipMember(inner, 0) + gzipMember("last\n", 6);
+  ASSERT_NE(std::string::npos, gzip.find("\x1f\x8b\x08", 1));
+  EXPECT_EQ(inner + "last\n", gunzipString(gzip, 1));
+  EXPECT_EQ(inner + "last\n", gunzipString(gzip, 3));
+}
+
+TEST(NgramFileTest, invalid) {
+  const std::string gzip = gzipMember("first\n", 6);
+  EXPECT_EQ("error", gunzipString(gzip.substr(0, gzip.size() - 1), 1));
+  EXPECT_EQ("error", gunzipString(gzip.substr(0, gzip.size() - 1), 4));
+  EXPECT_EQ("", gunzipString("", 4));
+}
+
+TEST(NgramFileTest, textReader) {
+  // blank line in the middle, no newline at the end.
+  const std::string fileName = writeGzipFile(
+      "V 0 0\nS 0 0\nX 0_1 3_4\n\nX 2 5 extra\nX 1_2_3 4_5_6");
+  NgramTextReader reader(fileName, 2);
+  std::vector<int> positions;
+  Ngram ngram;
+  ASSERT_TRUE(reader.next(&positions, &ngram));
+  ASSERT_EQ(2, positions.size());
+  EXPECT_EQ(1, positions[1]);
+  ASSERT_EQ(2, ngram.size());
+  EXPECT_EQ(3, ngram[0]);
+  ASSERT_TRUE(reader.next(&positions, &ngram));
+  ASSERT_EQ(1, positions.size());
+  EXPECT_EQ(2, positions[0]);
+  ASSERT_EQ(1, ngram.size());
+  EXPECT_EQ(5, ngram[0]);
+  ASSERT_TRUE(reader.next(&positions, &ngram));
+  ASSERT_EQ(3, positions.size());
+  ASSERT_EQ(3, ngram.size());
+  EXPECT_EQ(6, ngram[2]);
+  EXPECT_FALSE(reader.next(&positions, &ngram));
+}
+
+TEST(NgramFileTest, textReaderMalformed) {
+  const std::string fileName = writeGzipFile("V 0 0\nS 0 0\nX 0_1\n");
+  NgramTextReader reader(fileName, 1);
+  std::vector<int> positions;
+  Ngram ngram;
+  EXPECT_DEATH(reader.next(&positions, &ngram), "at least 3 parts");
+}
+
+} // namespace
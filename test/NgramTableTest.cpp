@@ -0,0 +1,79 @@
+/*
+ * NgramTableTest.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include <gtest/gtest.h>
+#include "NgramTable.h"
+#include "Util.h"
+
+namespace {
+
+using namespace cam::eng::gen;
+
+Ngram makeNgram(const int first, const int second) {
+  Ngram res(1, first);
+  res.push_back(second);
+  return res;
+}
+
+void add(const Ngram& ngram, const std::vector<Coverage>& coverages,
+         NgramTable* table) {
+  std::vector<lm::WordIndex> kenlmIndices(ngram.begin(), ngram.end());
+  NgramCosts costs;
+  for (int i = 0; i < ngram.size(); ++i) {
+    costs.costs.push_back(ngram.size() - i);
+    // one feature per offset, equal to the offset.
+    costs.featureValues.push_back(i);
+  }
+  costs.deletionCost = 0.5;
+  costs.deletionFeatureValues.push_back(-1);
+  costs.lmBoundary = ngram.size();
+  costs.interiorLmScore = 0;
+  table->add(ngram, kenlmIndices, coverages, costs);
+}
+
+TEST(NgramTableTest, pools) {
+  // input: <s> 3 4 </s>
+  NgramTable table;
+  table.clear(10, 1, true);
+  std::vector<Coverage> coverages;
+  coverages.push_back(Coverage("1100"));
+  add(makeNgram(STARTSENTENCE, 3), coverages, &table);
+  coverages.assign(1, Coverage("0110"));
+  coverages.push_back(Coverage("0011"));
+  add(makeNgram(4, ENDSENTENCE), coverages, &table);
+  ASSERT_EQ(2, table.size());
+  EXPECT_EQ(10, table.id(0));
+  EXPECT_EQ(11, table.id(1));
+  EXPECT_TRUE(table.startsWithStart(0));
+  EXPECT_FALSE(table.endsWithEnd(0));
+  EXPECT_FALSE(table.startsWithStart(1));
+  EXPECT_TRUE(table.endsWithEnd(1));
+  EXPECT_EQ(2, table.ngramSize(1));
+  EXPECT_EQ(4, table.words(1)[0]);
+  EXPECT_EQ(ENDSENTENCE, table.kenlmIndices(1)[1]);
+  EXPECT_EQ(1, table.coverageBegin(1));
+  EXPECT_EQ(3, table.coverageEnd(1));
+  Coverage coverage;
+  table.coverage(2, &coverage);
+  EXPECT_TRUE(coverage == Coverage("0011"));
+  EXPECT_EQ(2, table.coverageCount(2));
+  EXPECT_EQ(1, table.cost(1, 1));
+  EXPECT_EQ(1, table.values(1, 1)[0]);
+  EXPECT_EQ(0.5, table.deletionCost(1));
+  EXPECT_EQ(-1, table.deletionValues(1)[0]);
+  // no language model score is precomputed for these n-grams.
+  EXPECT_TRUE(table.endKenlmState(0) == NULL);
+}
+
+TEST(NgramTableTest, noValues) {
+  NgramTable table;
+  table.clear(0, 1, false);
+  add(Ngram(1, 3), std::vector<Coverage>(1, Coverage("0100")), &table);
+  EXPECT_TRUE(table.values(0, 0) == NULL);
+  EXPECT_TRUE(table.deletionValues(0) == NULL);
+}
+
+} // namespace